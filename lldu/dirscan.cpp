@@ -0,0 +1,450 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "dirscan.hpp"
+#include "uringstat.hpp"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef HAVE_WIN
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_STATX
+#include <sys/sysmacros.h>  // makedev
+#endif
+
+#ifdef HAVE_GETDENTS
+#include <sys/syscall.h>
+
+// Record layout returned by getdents64, glibc does not export it.
+struct linux_dirent64 {
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+// getdents64 buffers are large (libc readdir uses ~32KB) so big directories need fewer
+// syscalls. A thread needs one buffer per open directory level; released buffers are kept
+// on a per-thread free list and reused by the next directory.
+static const size_t DENTS_BUF_SIZE = 256 * 1024;
+
+struct DentsBuffers {
+    std::vector<char*> freeList;
+    ~DentsBuffers() {
+        for (char* buf : freeList)
+            delete[] buf;
+    }
+};
+static thread_local DentsBuffers dentsBuffers;
+
+static char* acquireDentsBuf() {
+    if (dentsBuffers.freeList.empty())
+        return new char[DENTS_BUF_SIZE];
+    char* buf = dentsBuffers.freeList.back();
+    dentsBuffers.freeList.pop_back();
+    return buf;
+}
+
+static void releaseDentsBuf(char* buf) {
+    if (buf != nullptr)
+        dentsBuffers.freeList.push_back(buf);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+static void copyStat(FileStat& fileStat, const struct stat& filestat) {
+    fileStat.mode = filestat.st_mode;
+    fileStat.nlink = filestat.st_nlink;
+    fileStat.size = filestat.st_size;
+#ifdef HAVE_WIN
+    fileStat.blocks = 0;
+    fileStat.blksize = 0;
+#else
+    fileStat.blocks = filestat.st_blocks;
+    fileStat.blksize = filestat.st_blksize;
+#endif
+    fileStat.dev = filestat.st_dev;
+    fileStat.ino = filestat.st_ino;
+    fileStat.atime = filestat.st_atime;
+    fileStat.mtime = filestat.st_mtime;
+    fileStat.ctime = filestat.st_ctime;
+    fileStat.uid = filestat.st_uid;
+    fileStat.gid = filestat.st_gid;
+}
+
+#ifdef HAVE_STATX
+//-------------------------------------------------------------------------------------------------
+unsigned statxMask(unsigned need) {
+    unsigned mask = 0;
+    if (need & DirScan::NEED_TYPE)
+        mask |= STATX_TYPE | STATX_MODE;
+    if (need & DirScan::NEED_SIZE)
+        mask |= STATX_SIZE | STATX_BLOCKS;
+    if (need & DirScan::NEED_LINKS)
+        mask |= STATX_NLINK;
+    if (need & DirScan::NEED_INODE)
+        mask |= STATX_INO;
+    if (need & DirScan::NEED_TIMES)
+        mask |= STATX_ATIME | STATX_MTIME | STATX_CTIME;
+    if (need & DirScan::NEED_OWNER)
+        mask |= STATX_UID | STATX_GID;
+    return mask;
+}
+
+//-------------------------------------------------------------------------------------------------
+void copyStatx(FileStat& fileStat, const struct statx& stx) {
+    fileStat.mode = stx.stx_mode;
+    fileStat.nlink = stx.stx_nlink;
+    fileStat.size = stx.stx_size;
+    fileStat.blocks = stx.stx_blocks;
+    fileStat.blksize = stx.stx_blksize;
+    fileStat.dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    fileStat.ino = stx.stx_ino;
+    fileStat.atime = stx.stx_atime.tv_sec;
+    fileStat.mtime = stx.stx_mtime.tv_sec;
+    fileStat.ctime = stx.stx_ctime.tv_sec;
+    fileStat.uid = stx.stx_uid;
+    fileStat.gid = stx.stx_gid;
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+DirScan::DirScan(const lstring& _dirPath) :
+    dirPath(_dirPath), files(nullptr), curName(""), curLen(0), curType(TYPE_UNKNOWN), curStat(-1),
+    buffered(false), nextEntry(0), ring(nullptr), ringNeed(0) {
+#ifdef HAVE_WIN
+    files = new Directory_files(dirPath);
+#else
+    open(-1, nullptr);
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+DirScan::DirScan(const DirScan& parent, const lstring& _dirPath) :
+    dirPath(_dirPath), files(nullptr), curName(""), curLen(0), curType(TYPE_UNKNOWN), curStat(-1),
+    buffered(false), nextEntry(0), ring(nullptr), ringNeed(0) {
+#ifdef HAVE_WIN
+    files = new Directory_files(dirPath);
+#else
+    size_t slash = dirPath.find_last_of(Directory_files::SLASH_CHAR);
+    if (parent.dirFd != -1 && parent.files == nullptr && slash != std::string::npos)
+        open(parent.dirFd, dirPath.c_str() + slash + 1);
+    else
+        open(-1, nullptr);
+#endif
+}
+
+#ifndef HAVE_WIN
+//-------------------------------------------------------------------------------------------------
+// Open dirPath, or name relative to parentFd when parentFd is valid.
+void DirScan::open(int parentFd, const char* name) {
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (parentFd != -1)
+        dirFd = openat(parentFd, name, flags | O_NOFOLLOW);
+    else
+        dirFd = ::open(dirPath, flags);
+#ifdef HAVE_GETDENTS
+    dentsBuf = nullptr;
+    dentsLen = dentsPos = 0;
+#else
+    dir = nullptr;
+    if (dirFd != -1 && (dir = fdopendir(dirFd)) == nullptr) {
+        close(dirFd);
+        dirFd = -1;
+    }
+#endif
+    if (dirFd == -1 && errno != EACCES)
+        files = new Directory_files(dirPath);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+DirScan::~DirScan() {
+    delete files;
+#ifdef HAVE_GETDENTS
+    releaseDentsBuf(dentsBuf);
+    if (dirFd != -1)
+        close(dirFd);
+#elif !defined(HAVE_WIN)
+    if (dir != nullptr)
+        closedir(dir);
+#endif
+}
+
+#ifndef HAVE_WIN
+//-------------------------------------------------------------------------------------------------
+static DirScan::Type direntType(unsigned char d_type) {
+#ifdef DT_DIR
+    switch (d_type) {
+    case DT_REG: return DirScan::TYPE_FILE;
+    case DT_DIR: return DirScan::TYPE_DIR;
+    case DT_LNK: return DirScan::TYPE_LINK;
+    case DT_UNKNOWN: return DirScan::TYPE_UNKNOWN;
+    default: return DirScan::TYPE_OTHER;
+    }
+#else
+    return DirScan::TYPE_UNKNOWN;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline bool isDotOrDotDot(const char* dname) {
+    return dname[0] == '.' && (dname[1] == '\0' || (dname[1] == '.' && dname[2] == '\0'));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Next raw entry (excluding . and ..) from the open directory fd.
+// With getdents64 the name points into the reusable buffer, nothing is copied.
+bool DirScan::readEntry(const char*& name, Type& type) {
+#ifdef HAVE_GETDENTS
+    if (dirFd == -1)
+        return false;
+    for (;;) {
+        if (dentsPos >= dentsLen) {
+            if (dentsBuf == nullptr)
+                dentsBuf = acquireDentsBuf();
+            long len = syscall(SYS_getdents64, dirFd, dentsBuf, DENTS_BUF_SIZE);
+            if (len <= 0)
+                return false;
+            dentsLen = (size_t)len;
+            dentsPos = 0;
+        }
+        const linux_dirent64* dent = (const linux_dirent64*)(dentsBuf + dentsPos);
+        dentsPos += dent->d_reclen;
+        if (!isDotOrDotDot(dent->d_name)) {
+            name = dent->d_name;
+            type = direntType(dent->d_type);
+            return true;
+        }
+    }
+#else
+    if (dir == nullptr)
+        return false;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (!isDotOrDotDot(entry->d_name)) {
+            name = entry->d_name;
+            type = direntType(entry->d_type);
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Advance to next entry, skipping . and ..
+bool DirScan::more() {
+    curStat = -1;
+    if (buffered) {
+#ifndef HAVE_WIN
+        if (nextEntry >= entries.size() && !fillChunk())
+            return false;
+#endif
+        const Entry& bufEntry = entries[nextEntry++];
+        curName = names.data() + bufEntry.nameOff;
+        curLen = bufEntry.nameLen;
+        curType = bufEntry.type;
+        curStat = bufEntry.statIdx;
+        return true;
+    }
+    if (files != nullptr) {
+        if (!files->more())
+            return false;
+        files->fullName(filesName);
+        size_t pos = filesName.find_last_of(Directory_files::SLASH_CHAR);
+        curName = filesName.c_str() + ((pos == std::string::npos) ? 0 : pos + 1);
+        curLen = strlen(curName);
+        curType = files->is_directory() ? TYPE_DIR : TYPE_UNKNOWN;
+        return true;
+    }
+#ifndef HAVE_WIN
+    if (readEntry(curName, curType)) {
+        curLen = strlen(curName);
+        return true;
+    }
+#endif
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Switch to chunked reading, more(), type() and stat() then serve entries from the current
+// chunk in readdir order. Memory stays at one ring depth of entries however large the directory.
+void DirScan::prefetch(UringStat& _ring, unsigned need) {
+#ifndef HAVE_WIN
+    if (buffered || files != nullptr || dirFd == -1 || !_ring.isOpen())
+        return;
+    ring = &_ring;
+    ringNeed = need | NEED_TYPE;
+    buffered = true;
+    entries.clear();
+    nextEntry = 0;
+#endif
+}
+
+#ifndef HAVE_WIN
+//-------------------------------------------------------------------------------------------------
+// Read the next ring depth of entries and stat the non-directory ones as one io_uring batch.
+bool DirScan::fillChunk() {
+    entries.clear();
+    names.clear();
+    nextEntry = 0;
+    size_t chunk = std::max(1u, ring->depth());
+    const char* name;
+    Type type;
+    while (entries.size() < chunk && readEntry(name, type)) {
+        Entry bufEntry;
+        bufEntry.nameOff = names.size();
+        bufEntry.nameLen = strlen(name);
+        bufEntry.type = type;
+        bufEntry.statIdx = -1;
+        names.insert(names.end(), name, name + bufEntry.nameLen + 1);
+        entries.push_back(bufEntry);
+    }
+    if (entries.empty())
+        return false;
+
+    statNames.clear();
+    statEntries.clear();
+    for (unsigned idx = 0; idx < entries.size(); idx++) {
+        if (entries[idx].type != TYPE_DIR) {
+            statNames.push_back(names.data() + entries[idx].nameOff);
+            statEntries.push_back(idx);
+        }
+    }
+    if (!statNames.empty() && ring->statBatch(dirFd, statNames, ringNeed, stats, status)) {
+        for (unsigned idx = 0; idx < statEntries.size(); idx++)
+            entries[statEntries[idx]].statIdx = (int)idx;
+    }
+    return true;
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+const char* DirScan::name() const {
+    return curName;
+}
+
+//-------------------------------------------------------------------------------------------------
+std::string_view DirScan::nameView() const {
+    return std::string_view(curName, curLen);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry type without calling stat, TYPE_UNKNOWN if the filesystem does not report it.
+DirScan::Type DirScan::type() const {
+#ifndef HAVE_WIN
+    if (curType == TYPE_UNKNOWN && curStat >= 0 && status[curStat] == 0) {
+        unsigned mode = stats[curStat].mode;
+        return S_ISDIR(mode) ? TYPE_DIR : S_ISREG(mode) ? TYPE_FILE : S_ISLNK(mode) ? TYPE_LINK : TYPE_OTHER;
+    }
+#endif
+    return curType;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool DirScan::is_directory() const {
+    if (files != nullptr)
+        return files->is_directory();
+    Type entryType = type();
+    if (entryType != TYPE_UNKNOWN)
+        return entryType == TYPE_DIR;
+
+#ifndef HAVE_WIN
+    // Filesystem does not fill d_type (some NFS, older XFS), ask the inode.
+    FileStat fileStat;
+    return stat(fileStat, NEED_TYPE) && S_ISDIR(fileStat.mode);
+#else
+    return false;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+bool DirScan::stat(FileStat& fileStat, unsigned need) const {
+    if (curStat >= 0) {
+        // Prefetched by io_uring batch
+        if (status[curStat] != 0) {
+            errno = status[curStat];
+            return false;
+        }
+        fileStat = stats[curStat];
+        return true;
+    }
+#ifndef HAVE_WIN
+    if (files == nullptr && dirFd != -1) {
+#ifdef HAVE_STATX
+        struct statx stx;
+        if (statx(dirFd, curName, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, statxMask(need), &stx) == 0) {
+            copyStatx(fileStat, stx);
+            return true;
+        }
+        if (errno != ENOSYS)
+            return false;
+#endif
+        struct stat filestat;
+        if (fstatat(dirFd, curName, &filestat, AT_SYMLINK_NOFOLLOW) != 0)
+            return false;
+        copyStat(fileStat, filestat);
+        return true;
+    }
+#endif
+    lstring fname;
+    return statPath(fullName(fname), fileStat, need);
+}
+
+//-------------------------------------------------------------------------------------------------
+bool DirScan::dirStat(FileStat& fileStat) const {
+#ifndef HAVE_WIN
+    struct stat filestat;
+    if (files == nullptr && dirFd != -1 && fstat(dirFd, &filestat) == 0) {
+        copyStat(fileStat, filestat);
+        return true;
+    }
+#endif
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool DirScan::statPath(const char* path, FileStat& fileStat, unsigned need) {
+#ifdef HAVE_STATX
+    struct statx stx;
+    if (statx(AT_FDCWD, path, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, statxMask(need), &stx) == 0) {
+        copyStatx(fileStat, stx);
+        return true;
+    }
+    if (errno != ENOSYS)
+        return false;
+#endif
+    struct stat filestat;
+#ifdef HAVE_WIN
+    if (::stat(path, &filestat) != 0)
+        return false;
+#else
+    // Use lstat to avoid following the link to its target
+    if (::lstat(path, &filestat) != 0)
+        return false;
+#endif
+    copyStat(fileStat, filestat);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+lstring& DirScan::fullName(lstring& fname) const {
+    if (files != nullptr) {
+        fname = filesName;
+        return fname;
+    }
+    fname = dirPath;
+    if (fname.empty() || fname.back() != Directory_files::SLASH_CHAR)
+        fname += Directory_files::SLASH_CHAR;
+    fname.append(curName, curLen);
+    return fname;
+}
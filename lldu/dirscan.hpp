@@ -0,0 +1,143 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Directory reader which also reports each entry's type from readdir (dirent::d_type),
+// so callers can classify entries without a stat call.
+//
+// On Linux the listing is read with getdents64 into a large buffer reused between
+// directories, entries are parsed in place and names are handed out without copying.
+//
+// Entries are stat'ed relative to the open directory fd (fstatat or statx) so the kernel
+// does not walk the full path again for every file, and subdirectories can be opened
+// relative to their parent with openat. Full path strings are only built on request.
+//
+// Falls back to Directory_files on Windows and when the path is not a plain directory
+// (ex: a wildcard pattern, which Directory_files knows how to expand).
+
+#pragma once
+
+#include "ll_stdhdr.hpp"
+#include "directory.hpp"
+
+#include <time.h>
+#include <sys/stat.h>
+#include <string_view>
+#include <vector>
+
+#ifndef HAVE_WIN
+#include <dirent.h>
+#endif
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+#define HAVE_STATX
+#endif
+
+#ifdef __linux__
+#define HAVE_GETDENTS
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Subset of stat fields lldu uses, filled from fstatat, statx or lstat.
+struct FileStat {
+    unsigned mode;
+    size_t nlink;
+    size_t size;
+    size_t blocks;
+    size_t blksize;
+    unsigned long long dev;
+    unsigned long long ino;
+    time_t atime;
+    time_t mtime;
+    time_t ctime;
+    unsigned uid;
+    unsigned gid;
+};
+
+#ifdef HAVE_STATX
+// statx helpers, shared with the io_uring engine.
+unsigned statxMask(unsigned need);
+void copyStatx(FileStat& fileStat, const struct statx& stx);
+#endif
+
+class UringStat;
+
+//-------------------------------------------------------------------------------------------------
+class DirScan {
+public:
+    enum Type { TYPE_UNKNOWN, TYPE_FILE, TYPE_DIR, TYPE_LINK, TYPE_OTHER };
+
+    // FileStat fields the caller needs, lets statx ask the filesystem for less.
+    enum Need {
+        NEED_TYPE = 1, NEED_SIZE = 2, NEED_LINKS = 4, NEED_INODE = 8, NEED_TIMES = 16, NEED_OWNER = 32
+    };
+
+    DirScan(const lstring& dirPath);
+    // Open subdirectory dirPath of parent by its last path component, relative to parent's fd.
+    // parent need not be positioned on it (-snapshot replays recorded subdirectories).
+    DirScan(const DirScan& parent, const lstring& dirPath);
+    ~DirScan();
+
+    bool more();
+    // Stat entries through io_uring (-engine=uring), a ring depth chunk of the listing at a time.
+    void prefetch(UringStat& ring, unsigned need);
+    const char* name() const;
+    std::string_view nameView() const;  // valid until next more()
+    Type type() const;
+    bool is_directory() const;
+    lstring& fullName(lstring& fname) const;
+    const lstring& path() const { return dirPath; }
+
+    // Stat current entry without following links, relative to directory fd when available.
+    bool stat(FileStat& fileStat, unsigned need) const;
+    // Stat path without following links.
+    static bool statPath(const char* path, FileStat& fileStat, unsigned need);
+    // Stat the directory itself (fstat of its fd), false for the fallback reader.
+    bool dirStat(FileStat& fileStat) const;
+    bool isFallback() const { return files != nullptr; }
+
+private:
+    DirScan(const DirScan&) = delete;
+    DirScan& operator=(const DirScan&) = delete;
+#ifndef HAVE_WIN
+    void open(int parentFd, const char* name);
+    bool readEntry(const char*& name, Type& type);
+    bool fillChunk();
+#endif
+
+    lstring dirPath;
+    Directory_files* files;     // fallback reader
+    lstring filesName;
+#ifndef HAVE_WIN
+    int dirFd;
+#ifdef HAVE_GETDENTS
+    char* dentsBuf;             // per-thread reusable getdents64 buffer
+    size_t dentsLen;
+    size_t dentsPos;
+#else
+    DIR* dir;
+#endif
+#endif
+
+    // Current entry
+    const char* curName;
+    size_t curLen;
+    Type curType;
+    int curStat;                // index into stats when prefetched, else -1
+
+    // Current chunk of entries buffered by prefetch()
+    struct Entry {
+        size_t nameOff;
+        size_t nameLen;
+        Type type;
+        int statIdx;
+    };
+    bool buffered;
+    size_t nextEntry;
+    UringStat* ring;
+    unsigned ringNeed;
+    std::vector<Entry> entries;
+    std::vector<char> names;
+    std::vector<FileStat> stats;
+    std::vector<int> status;
+    std::vector<const char*> statNames;
+    std::vector<unsigned> statEntries;
+};
@@ -0,0 +1,67 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "dirtree.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+DirTree::DirTree() : count(0) {
+}
+
+//-------------------------------------------------------------------------------------------------
+uint32_t DirTree::add(uint32_t parent, std::string_view name, unsigned depth) {
+    std::lock_guard<std::mutex> guard(lock);
+    if ((count >> BLOCK_BITS) == blocks.size())
+        blocks.emplace_back(new Node[BLOCK_MASK + 1]);
+    uint32_t idx = count++;
+    Node& entry = nodeAt(idx);
+    memset(&entry, 0, sizeof(entry));
+    entry.parent = parent;
+    entry.depth = (uint16_t)std::min(depth, 0xffffu);
+    entry.nameLen = (uint16_t)std::min(name.length(), (size_t)0xffff);
+    entry.nameOff = names.size();
+    names.append(name.data(), entry.nameLen);
+    return idx;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DirTree::setOwn(uint32_t idx, const DuSums& sums) {
+    std::lock_guard<std::mutex> guard(lock);
+    Node& entry = nodeAt(idx);
+    entry.count = sums.count;
+    entry.hardlinks = sums.hardlinks;
+    entry.diskSize = sums.diskSize;
+    entry.fileSize = sums.fileSize;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DirTree::rollUp() {
+    for (uint32_t idx = count; idx-- > 0; ) {
+        const Node& child = node(idx);
+        if (child.parent != NO_NODE) {
+            Node& parent = nodeAt(child.parent);
+            parent.count += child.count;
+            parent.hardlinks += child.hardlinks;
+            parent.diskSize += child.diskSize;
+            parent.fileSize += child.fileSize;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+std::string DirTree::path(uint32_t idx, char separator) const {
+    std::vector<uint32_t> chain;
+    for (uint32_t at = idx; at != NO_NODE; at = node(at).parent)
+        chain.push_back(at);
+
+    std::string fullPath;
+    for (auto iter = chain.rbegin(); iter != chain.rend(); iter++) {
+        const Node& entry = node(*iter);
+        if (!fullPath.empty() && fullPath.back() != separator)
+            fullPath += separator;
+        fullPath.append(names, entry.nameOff, entry.nameLen);
+    }
+    return fullPath;
+}
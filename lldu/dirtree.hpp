@@ -0,0 +1,61 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Directory tree with subtree totals, for -depth-report=N.
+//
+// The scan adds one node per directory with its own file totals; rollUp() then adds every
+// node into its parent in one reverse pass, as a child is always added after its parent.
+// Nodes are 48 bytes in fixed size blocks which never move, and names are offsets into one
+// shared string pool, so memory is about 48 bytes plus the name length per directory.
+
+#pragma once
+
+#include "dulist.hpp"
+
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class DirTree {
+public:
+    static const uint32_t NO_NODE = UINT32_MAX;
+
+    struct Node {
+        uint32_t parent;
+        uint16_t depth;
+        uint16_t nameLen;
+        uint64_t nameOff;
+        uint64_t count;
+        uint64_t hardlinks;
+        uint64_t diskSize;
+        uint64_t fileSize;
+    };
+
+    DirTree();
+
+    // Add directory 'name' below parent (NO_NODE for a scan argument), thread safe.
+    uint32_t add(uint32_t parent, std::string_view name, unsigned depth);
+    // Set node's own file totals, thread safe.
+    void setOwn(uint32_t idx, const DuSums& sums);
+    // Add every node's totals into its parent, call once after the scan.
+    void rollUp();
+
+    size_t size() const { return count; }
+    const Node& node(uint32_t idx) const { return blocks[idx >> BLOCK_BITS][idx & BLOCK_MASK]; }
+    // Full path of node, names joined with separator.
+    std::string path(uint32_t idx, char separator) const;
+
+private:
+    static const unsigned BLOCK_BITS = 16;
+    static const uint32_t BLOCK_MASK = (1u << BLOCK_BITS) - 1;
+
+    Node& nodeAt(uint32_t idx) { return blocks[idx >> BLOCK_BITS][idx & BLOCK_MASK]; }
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<Node[]>> blocks;
+    uint32_t count;
+    std::string names;
+};
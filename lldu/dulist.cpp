@@ -0,0 +1,296 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "dulist.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+static const size_t INIT_SLOTS = 64;
+
+//-------------------------------------------------------------------------------------------------
+static inline uint64_t mixHash(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// FNV-1a, only used for extensions too long to pack.
+static inline uint64_t hashText(std::string_view text) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char chr : text)
+        hash = (hash ^ (unsigned char)chr) * 0x100000001B3ULL;
+    return mixHash(hash);
+}
+
+//-------------------------------------------------------------------------------------------------
+DuList::DuList() : used(0) {
+}
+
+//-------------------------------------------------------------------------------------------------
+// Pack up to 7 bytes plus length into key, length byte is never 0xff so never EMPTY_KEY.
+bool DuList::packKey(std::string_view ext, uint64_t& key) {
+    size_t len = ext.length();
+    if (len > 7)
+        return false;
+    key = (uint64_t)len << 56;
+    for (size_t idx = 0; idx < len; idx++)
+        key |= (uint64_t)(unsigned char)ext[idx] << (idx * 8);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+std::string_view DuList::keyName(const uint64_t& key) const {
+    if ((key & LONG_KEY) != 0) {
+        size_t off = (size_t)(key & ~LONG_KEY);
+        uint32_t len;
+        memcpy(&len, arena.data() + off, sizeof(len));
+        return std::string_view(arena.data() + off + sizeof(len), len);
+    }
+    // Packed bytes are in memory order on little endian, view them in place.
+    size_t len = (size_t)(key >> 56);
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+    return std::string_view((const char*)&key, len);
+#else
+    static thread_local char buf[8];
+    for (size_t idx = 0; idx < len; idx++)
+        buf[idx] = (char)(key >> (idx * 8));
+    return std::string_view(buf, len);
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+DuList::Slot& DuList::slot(std::string_view ext) {
+    if ((used + 1) * 10 > slots.size() * 7)
+        grow();
+
+    uint64_t key;
+    bool packed = packKey(ext, key);
+    uint64_t hash = packed ? mixHash(key) : hashText(ext);
+    size_t mask = slots.size() - 1;
+    size_t idx = hash & mask;
+    for (;; idx = (idx + 1) & mask) {
+        Slot& slot = slots[idx];
+        if (slot.key == EMPTY_KEY)
+            break;
+        if (slot.hash == hash) {
+            if (packed ? (slot.key == key) : ((slot.key & LONG_KEY) != 0 && keyName(slot.key) == ext))
+                return slot;
+        }
+    }
+
+    if (!packed) {
+        // Intern in arena
+        key = LONG_KEY | arena.size();
+        uint32_t len = (uint32_t)ext.length();
+        arena.append((const char*)&len, sizeof(len));
+        arena.append(ext.data(), ext.length());
+    }
+    Slot& slot = slots[idx];
+    slot.key = key;
+    slot.hash = hash;
+    slot.sums = DuSums();
+    slot.hist = NO_HIST;
+    slot.age = NO_HIST;
+    slot.est = NO_HIST;
+    used++;
+    return slot;
+}
+
+//-------------------------------------------------------------------------------------------------
+SizeHist& DuList::histOf(Slot& slot) {
+    if (slot.hist == NO_HIST) {
+        slot.hist = (uint32_t)hists.size();
+        hists.emplace_back();
+    }
+    return hists[slot.hist];
+}
+
+//-------------------------------------------------------------------------------------------------
+AgeSums& DuList::ageOf(Slot& slot) {
+    if (slot.age == NO_HIST) {
+        slot.age = (uint32_t)agesList.size();
+        agesList.emplace_back();
+    }
+    return agesList[slot.age];
+}
+
+//-------------------------------------------------------------------------------------------------
+EstSums& DuList::estOf(Slot& slot) {
+    if (slot.est == NO_HIST) {
+        slot.est = (uint32_t)ests.size();
+        ests.emplace_back();
+    }
+    return ests[slot.est];
+}
+
+//-------------------------------------------------------------------------------------------------
+void DuList::grow() {
+    std::vector<Slot> newSlots(slots.empty() ? INIT_SLOTS : slots.size() * 2);
+    for (Slot& slot : newSlots)
+        slot.key = EMPTY_KEY;
+    size_t mask = newSlots.size() - 1;
+    for (const Slot& old : slots) {
+        if (old.key == EMPTY_KEY)
+            continue;
+        size_t idx = old.hash & mask;
+        while (newSlots[idx].key != EMPTY_KEY)
+            idx = (idx + 1) & mask;
+        newSlots[idx] = old;
+    }
+    slots.swap(newSlots);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DuList::merge(const DuList& src) {
+    for (const Slot& srcSlot : src.slots) {
+        if (srcSlot.key == EMPTY_KEY)
+            continue;
+        Slot& dst = slot(src.keyName(srcSlot.key));
+        dst.sums += srcSlot.sums;
+        if (srcSlot.hist != NO_HIST)
+            histOf(dst) += src.hists[srcSlot.hist];
+        if (srcSlot.age != NO_HIST)
+            ageOf(dst) += src.agesList[srcSlot.age];
+        if (srcSlot.est != NO_HIST)
+            estOf(dst) += src.ests[srcSlot.est];
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DuList::clear() {
+    if (used == 0)
+        return;
+    for (Slot& slot : slots)
+        slot.key = EMPTY_KEY;
+    used = 0;
+    arena.clear();
+    hists.clear();
+    agesList.clear();
+    ests.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DuList::getInfos(std::vector<DuInfo>& infos) const {
+    infos.reserve(infos.size() + used);
+    for (const Slot& slot : slots) {
+        if (slot.key == EMPTY_KEY)
+            continue;
+        std::string_view ext = keyName(slot.key);
+        DuInfo info;
+        static_cast<DuSums&>(info) = slot.sums;
+        info.ext.assign(ext.data(), ext.length());
+        if (slot.hist != NO_HIST)
+            info.hist = hists[slot.hist];
+        if (slot.age != NO_HIST)
+            info.age = agesList[slot.age];
+        if (slot.est != NO_HIST)
+            info.est = ests[slot.est];
+        infos.push_back(std::move(info));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+uint64_t SizeHist::total() const {
+    uint64_t sum = 0;
+    for (unsigned idx = 0; idx < BUCKETS; idx++)
+        sum += buckets[idx];
+    return sum;
+}
+
+//-------------------------------------------------------------------------------------------------
+uint64_t SizeHist::percentile(unsigned percent) const {
+    uint64_t files = total();
+    if (files == 0)
+        return 0;
+    // Rank of the file at percent, 1 based.
+    uint64_t rank = (files * percent + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+    uint64_t seen = 0;
+    for (unsigned idx = 0; idx < BUCKETS; idx++) {
+        if (seen + buckets[idx] >= rank) {
+            uint64_t low = bucketLow(idx);
+            uint64_t width = (idx == 0) ? 0 : low;      // bucket is [low, 2*low)
+            return low + (uint64_t)((double)width * (rank - seen - 1) / buckets[idx]);
+        }
+        seen += buckets[idx];
+    }
+    return bucketLow(BUCKETS - 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+const unsigned AgeSums::DAYS[AgeSums::BUCKETS] = { 0, 30, 90, 365 };
+
+uint64_t AgeSums::countOlder(unsigned days) const {
+    uint64_t sum = 0;
+    for (unsigned idx = bucketFor(days); idx < BUCKETS; idx++)
+        sum += counts[idx];
+    return sum;
+}
+
+uint64_t AgeSums::sizeOlder(unsigned days) const {
+    uint64_t sum = 0;
+    for (unsigned idx = bucketFor(days); idx < BUCKETS; idx++)
+        sum += sizes[idx];
+    return sum;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Sample variance of n sizes from their sum and sum of squares.
+static double sampleVariance(double samples, double sum, double sumSq) {
+    if (samples < 2)
+        return 0;
+    double mean = sum / samples;
+    return std::max(0.0, (sumSq - samples * mean * mean) / (samples - 1));
+}
+
+//-------------------------------------------------------------------------------------------------
+void DuInfo::extrapolate(std::vector<DuInfo>& infos) {
+    DuInfo pool;
+    for (const DuInfo& info : infos) {
+        pool.fileSize += info.fileSize;
+        pool.diskSize += info.diskSize;
+        pool.hardlinks += info.hardlinks;
+        pool.est += info.est;
+    }
+    for (DuInfo& info : infos)
+        info.extrapolate(pool);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Each extension is a stratum of N regular files with a simple random sample of n. The total
+// is N * mean, its variance N^2 * s^2 / n * (1 - n/N).
+// An extension with no file in the sample gets N * the pooled mean. Its variance adds the
+// spread of N unseen files (N * s^2) to the pooled mean's own (N^2 * s^2 / n), so the margin
+// shows the guess instead of claiming none.
+void DuInfo::extrapolate(const DuInfo& pool) {
+    double population = (double)(count - softlinks);
+    if (population <= 0)
+        return;
+    if (est.samples == 0) {
+        double poolSamples = (double)pool.est.samples;
+        if (pool.est.samples == 0)
+            return;
+        double poolVar = sampleVariance(poolSamples, (double)pool.fileSize, pool.est.sizeSq);
+        est.sizeVar = population * poolVar + population * population * poolVar / poolSamples;
+        poolVar = sampleVariance(poolSamples, (double)pool.diskSize, pool.est.diskSq);
+        est.diskVar = population * poolVar + population * population * poolVar / poolSamples;
+        fileSize = (size_t)(pool.fileSize * population / poolSamples + 0.5);
+        diskSize = (size_t)(pool.diskSize * population / poolSamples + 0.5);
+        hardlinks = (size_t)(pool.hardlinks * population / poolSamples + 0.5);
+        return;
+    }
+
+    double samples = (double)est.samples;
+    if (population <= samples)
+        return;
+    double scale = population / samples;
+    double sampleVar = sampleVariance(samples, (double)fileSize, est.sizeSq);
+    est.sizeVar = population * population * sampleVar / samples * (1 - samples / population);
+    sampleVar = sampleVariance(samples, (double)diskSize, est.diskSq);
+    est.diskVar = population * population * sampleVar / samples * (1 - samples / population);
+    fileSize = (size_t)(fileSize * scale + 0.5);
+    diskSize = (size_t)(diskSize * scale + 0.5);
+    hardlinks = (size_t)(hardlinks * scale + 0.5);
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Per extension totals collected by the scan.
+//
+// Flat open addressing hash keyed by the extension. Extensions up to 7 bytes are packed
+// with their length into the 64 bit key, so the common case has no string compare and no
+// allocation. Longer extensions are interned once in the list's own arena and keyed by
+// their arena offset. Entries are unordered, reports sort them when printing.
+// With -histogram an entry also gets a fixed array of power of two size buckets, allocated
+// once when the extension is first seen, -age likewise adds a small set of age buckets
+// and -estimate the sums of its file size sample.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+struct DuSums {
+    size_t count;
+    size_t diskSize;
+    size_t fileSize;
+    size_t hardlinks;
+    size_t softlinks;
+    DuSums() : count(0), diskSize(0), fileSize(0), hardlinks(0), softlinks(0) {}
+    DuSums& operator+=(const DuSums& rhs) {
+        count += rhs.count;
+        diskSize += rhs.diskSize;
+        fileSize += rhs.fileSize;
+        hardlinks += rhs.hardlinks;
+        softlinks += rhs.softlinks;
+        return *this;
+    }
+    DuSums& operator-=(const DuSums& rhs) {
+        count -= rhs.count;
+        diskSize -= rhs.diskSize;
+        fileSize -= rhs.fileSize;
+        hardlinks -= rhs.hardlinks;
+        softlinks -= rhs.softlinks;
+        return *this;
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+// File size distribution, bucket 0 is empty files and bucket N holds sizes [2^(N-1), 2^N).
+struct SizeHist {
+    static const unsigned BUCKETS = 48;     // last bucket holds 2^46 (64TB) and up
+    uint64_t buckets[BUCKETS];
+
+    SizeHist() { memset(buckets, 0, sizeof(buckets)); }
+
+    static unsigned bucket(uint64_t size) {
+        if (size == 0)
+            return 0;
+#if defined(__GNUC__) || defined(__clang__)
+        unsigned bits = 64 - (unsigned)__builtin_clzll(size);
+#else
+        unsigned bits = 0;
+        for (uint64_t rest = size; rest != 0; rest >>= 1)
+            bits++;
+#endif
+        return (bits < BUCKETS) ? bits : BUCKETS - 1;
+    }
+    static uint64_t bucketLow(unsigned idx) { return (idx == 0) ? 0 : 1ULL << (idx - 1); }
+
+    void add(uint64_t size) { buckets[bucket(size)]++; }
+    SizeHist& operator+=(const SizeHist& rhs) {
+        for (unsigned idx = 0; idx < BUCKETS; idx++)
+            buckets[idx] += rhs.buckets[idx];
+        return *this;
+    }
+    uint64_t total() const;
+    // Size at percent (1..100) of files, interpolated inside its bucket.
+    uint64_t percentile(unsigned percent) const;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Files and bytes by age (now - mtime or atime), buckets start at 0, 30, 90 and 365 days.
+struct AgeSums {
+    static const unsigned BUCKETS = 4;
+    static const unsigned DAYS[BUCKETS];
+    uint64_t counts[BUCKETS];
+    uint64_t sizes[BUCKETS];
+
+    AgeSums() { memset(counts, 0, sizeof(counts)); memset(sizes, 0, sizeof(sizes)); }
+
+    static unsigned bucket(int64_t ageSecs) {
+        unsigned idx = BUCKETS - 1;
+        while (idx != 0 && ageSecs < (int64_t)DAYS[idx] * 86400)
+            idx--;
+        return idx;
+    }
+    // First bucket holding files at least days old (days between bounds round up).
+    static unsigned bucketFor(unsigned days) {
+        unsigned idx = 0;
+        while (idx < BUCKETS && DAYS[idx] < days)
+            idx++;
+        return idx;
+    }
+
+    void add(int64_t ageSecs, uint64_t size) {
+        unsigned idx = bucket(ageSecs);
+        counts[idx]++;
+        sizes[idx] += size;
+    }
+    AgeSums& operator+=(const AgeSums& rhs) {
+        for (unsigned idx = 0; idx < BUCKETS; idx++) {
+            counts[idx] += rhs.counts[idx];
+            sizes[idx] += rhs.sizes[idx];
+        }
+        return *this;
+    }
+    // Files or bytes at least days old.
+    uint64_t countOlder(unsigned days) const;
+    uint64_t sizeOlder(unsigned days) const;
+};
+
+//-------------------------------------------------------------------------------------------------
+// -estimate, regular files of an extension which were stat'ed. The DuSums sizes only hold
+// the sample, counts are exact, see DuInfo::extrapolate.
+struct EstSums {
+    uint64_t samples;
+    double sizeSq;          // sum of squared file sizes
+    double diskSq;          // sum of squared disk sizes
+    double sizeVar;         // variance of the extrapolated file size, after extrapolate
+    double diskVar;         // variance of the extrapolated disk size, after extrapolate
+
+    EstSums() : samples(0), sizeSq(0), diskSq(0), sizeVar(0), diskVar(0) {}
+
+    void add(uint64_t size, uint64_t diskSize) {
+        samples++;
+        sizeSq += (double)size * size;
+        diskSq += (double)diskSize * diskSize;
+    }
+    EstSums& operator+=(const EstSums& rhs) {
+        samples += rhs.samples;
+        sizeSq += rhs.sizeSq;
+        diskSq += rhs.diskSq;
+        sizeVar += rhs.sizeVar;
+        diskVar += rhs.diskVar;
+        return *this;
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+struct DuInfo : DuSums {
+    std::string ext;
+    SizeHist hist;
+    AgeSums age;
+    EstSums est;
+    DuInfo() {}
+    DuInfo(std::string _str, size_t _count, size_t _diskSize, size_t _fileSize, size_t _links ) :
+        ext(_str) {
+        count = _count;
+        diskSize = _diskSize;
+        fileSize = _fileSize;
+        hardlinks = _links;
+    }
+
+    // -estimate, scale each entry's sample sizes up to all of its regular files and set
+    // est.sizeVar. Entries without a sample use the pooled sample of all entries.
+    static void extrapolate(std::vector<DuInfo>& infos);
+
+private:
+    void extrapolate(const DuInfo& pool);
+};
+
+//-------------------------------------------------------------------------------------------------
+class DuList {
+public:
+    DuList();
+
+    // Totals for ext, added if new.
+    DuSums& operator[](std::string_view ext) { return slot(ext).sums; }
+    // Size histogram for ext, added if new.
+    SizeHist& histogram(std::string_view ext) { return histOf(slot(ext)); }
+    // Age buckets for ext, added if new.
+    AgeSums& ages(std::string_view ext) { return ageOf(slot(ext)); }
+    // Size sample for ext, added if new.
+    EstSums& estimates(std::string_view ext) { return estOf(slot(ext)); }
+
+    void merge(const DuList& src);
+    void clear();
+    bool empty() const { return used == 0; }
+    size_t size() const { return used; }
+
+    // Append entries as DuInfo records (unordered).
+    void getInfos(std::vector<DuInfo>& infos) const;
+
+    template <typename Func>
+    void forEach(Func func) const {
+        for (const Slot& slot : slots) {
+            if (slot.key != EMPTY_KEY)
+                func(keyName(slot.key), slot.sums);
+        }
+    }
+
+private:
+    static const uint64_t EMPTY_KEY = ~0ULL;
+    static const uint64_t LONG_KEY = 1ULL << 63;  // arena offset in low bits
+
+    static const uint32_t NO_HIST = UINT32_MAX;     // also no age or est
+
+    struct Slot {
+        uint64_t key;
+        uint64_t hash;
+        DuSums sums;
+        uint32_t hist;          // index in hists or NO_HIST
+        uint32_t age;           // index in agesList or NO_HIST
+        uint32_t est;           // index in ests or NO_HIST
+    };
+
+    Slot& slot(std::string_view ext);
+    SizeHist& histOf(Slot& slot);
+    AgeSums& ageOf(Slot& slot);
+    EstSums& estOf(Slot& slot);
+    static bool packKey(std::string_view ext, uint64_t& key);
+    std::string_view keyName(const uint64_t& key) const;
+    void grow();
+
+    std::vector<Slot> slots;    // power of 2 size
+    size_t used;
+    std::string arena;          // long extensions, [uint32 length][bytes]
+    std::vector<SizeHist> hists;
+    std::vector<AgeSums> agesList;
+    std::vector<EstSums> ests;
+};
@@ -0,0 +1,228 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "formatplan.hpp"
+#include "dulist.hpp"
+
+#include <algorithm>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char groupSep = ',';
+
+//-------------------------------------------------------------------------------------------------
+void FormatPlan::initGrouping() {
+    const struct lconv* conv = localeconv();
+    if (conv != nullptr && conv->thousands_sep != nullptr && strlen(conv->thousands_sep) == 1)
+        groupSep = conv->thousands_sep[0];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Same parsing as the original printParts, '%' then strtol width, optional .precision,
+// one field char. Unknown field chars are printed as is.
+void FormatPlan::compile(const char* customFmt, bool nameOnly) {
+    parts.clear();
+    char* fmt = (char*)customFmt;
+    while (*fmt) {
+        if (*fmt != '%') {
+            if (parts.empty() || parts.back().field != LITERAL)
+                parts.push_back(Part{ LITERAL, false, false, false, 0, -1, 0, "" });
+            parts.back().text += *fmt++;
+            continue;
+        }
+
+        const char* begFmt = fmt;
+        Part part{ LITERAL, false, false, false, 0, -1, 0, "" };
+        for (const char* flag = fmt + 1; *flag == '-' || *flag == '0' || *flag == '+' || *flag == ' '; flag++) {
+            part.left |= (*flag == '-');
+            part.zeroPad |= (*flag == '0');
+        }
+        part.width = abs((int)strtol(fmt + 1, &fmt, 10));
+        if (*fmt == '.')
+            part.precision = (int)strtol(fmt + 1, &fmt, 10);
+        char chr = *fmt;
+        if (chr == '\0')
+            break;
+        std::string spec(begFmt, fmt - begFmt);
+        fmt++;
+
+        switch ((nameOnly && chr != '%') ? 'n' : chr) {
+        case 'e':   // Extension
+        case 'n':   // name
+            part.field = NAME;
+            part.text = spec + "s";
+            break;
+        case 'c': part.group = true;  part.field = COUNT; break;
+        case 'C': part.field = COUNT; break;
+        case 'l': part.group = true;  part.field = LINKS; break;
+        case 'L': part.field = LINKS; break;
+        case 's': part.group = true;  part.field = SIZE; break;
+        case 'S': part.field = SIZE; break;
+        case 'p':
+        case 'P':   // percentile, pNN
+            part.group = (chr == 'p');
+            part.field = PERCENTILE;
+            part.arg = (unsigned)strtoul(fmt, &fmt, 10);
+            part.arg = std::max(1u, std::min(part.arg ? part.arg : 50u, 100u));
+            break;
+        case 'h':
+            part.field = BUCKETS;
+            break;
+        case 'a':
+        case 'A':   // size at least aNN days old
+        case 'o':
+        case 'O':   // count at least oNN days old
+            part.group = (chr == 'a' || chr == 'o');
+            part.field = (chr == 'a' || chr == 'A') ? AGE_SIZE : AGE_COUNT;
+            part.arg = (unsigned)strtoul(fmt, &fmt, 10);
+            break;
+        case 'm': part.group = true;  part.field = MARGIN; break;
+        case 'M': part.field = MARGIN; break;
+        default:
+            if (parts.empty() || parts.back().field != LITERAL)
+                parts.push_back(Part{ LITERAL, false, false, false, 0, -1, 0, "" });
+            parts.back().text += chr;
+            continue;
+        }
+        if (part.field != NAME && !part.group)
+            part.text = spec + "zu";
+        parts.push_back(part);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+bool FormatPlan::needsStat() const {
+    for (const Part& part : parts) {
+        if (part.field != LITERAL && part.field != NAME && part.field != COUNT)
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool FormatPlan::needsHist() const {
+    for (const Part& part : parts) {
+        if (part.field == PERCENTILE || part.field == BUCKETS)
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool FormatPlan::needsAge() const {
+    for (const Part& part : parts) {
+        if (part.field == AGE_SIZE || part.field == AGE_COUNT)
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Bucket lows with binary unit suffix, ex: 0:3 1:2 512:10 4K:7 1M:2
+void FormatPlan::appendBuckets(std::string& out, const SizeHist& hist) {
+    static const char UNITS[] = " KMGTP";
+    bool first = true;
+    for (unsigned idx = 0; idx < SizeHist::BUCKETS; idx++) {
+        if (hist.buckets[idx] == 0)
+            continue;
+        unsigned long long low = SizeHist::bucketLow(idx);
+        unsigned unit = 0;
+        while (low >= 1024 && unit + 1 < sizeof(UNITS) - 1) {
+            low /= 1024;
+            unit++;
+        }
+        char buf[48];
+        int len = snprintf(buf, sizeof(buf), "%s%llu%.*s:%llu", first ? "" : " ", low,
+            unit ? 1 : 0, UNITS + unit, (unsigned long long)hist.buckets[idx]);
+        out.append(buf, std::min(len, (int)sizeof(buf) - 1));
+        first = false;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Digits with thousands separators, zero filled to precision, padded to width.
+void FormatPlan::appendNumber(std::string& out, const Part& part, size_t value) {
+    char digits[32];
+    int digitCnt = 0;
+    do {
+        digits[digitCnt++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 && digitCnt < (int)sizeof(digits));
+    while (digitCnt < part.precision && digitCnt < (int)sizeof(digits))
+        digits[digitCnt++] = '0';
+
+    char text[48];
+    int len = 0;
+    for (int idx = digitCnt - 1; idx >= 0; idx--) {
+        text[len++] = digits[idx];
+        if (idx != 0 && idx % 3 == 0)
+            text[len++] = groupSep;
+    }
+
+    int pad = part.width - len;
+    if (pad > 0 && !part.left)
+        out.append(pad, (part.zeroPad && part.precision < 0) ? '0' : ' ');
+    out.append(text, len);
+    if (pad > 0 && part.left)
+        out.append(pad, ' ');
+}
+
+//-------------------------------------------------------------------------------------------------
+void FormatPlan::render(std::string& out, const char* name, size_t count, size_t links, size_t size,
+        const DuInfo* detail) const {
+    char buf[512];
+    for (const Part& part : parts) {
+        size_t value = 0;
+        switch (part.field) {
+        case LITERAL:
+            out += part.text;
+            continue;
+        case NAME: {
+            int len = snprintf(buf, sizeof(buf), part.text.c_str(), name);
+            if (len >= (int)sizeof(buf)) {
+                std::string big(len + 1, '\0');
+                snprintf(&big[0], big.size(), part.text.c_str(), name);
+                out.append(big.c_str(), len);
+            } else if (len > 0) {
+                out.append(buf, len);
+            }
+            continue;
+        }
+        case COUNT: value = count; break;
+        case LINKS: value = links; break;
+        case SIZE:  value = size;  break;
+        case BUCKETS:
+            if (detail != nullptr)
+                appendBuckets(out, detail->hist);
+            continue;
+        case PERCENTILE:
+        case AGE_SIZE:
+        case AGE_COUNT:
+        case MARGIN:
+            if (detail == nullptr) {
+                out.append(part.width, ' ');
+                continue;
+            }
+            if (part.field == PERCENTILE)
+                value = detail->hist.percentile(part.arg);
+            else if (part.field == MARGIN)
+                value = (size_t)(1.96 * sqrt(diskSize ? detail->est.diskVar : detail->est.sizeVar) + 0.5);
+            else if (part.field == AGE_SIZE)
+                value = detail->age.sizeOlder(part.arg);
+            else
+                value = detail->age.countOlder(part.arg);
+            break;
+        }
+
+        if (part.group) {
+            appendNumber(out, part, value);
+        } else {
+            int len = snprintf(buf, sizeof(buf), part.text.c_str(), value);
+            if (len > 0)
+                out.append(buf, std::min(len, (int)sizeof(buf) - 1));
+        }
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Compiled -format, -FormatSummary and -CFMT strings.
+//
+// A format is parsed once into a list of parts (literal text, name, count, links, size).
+// Rows are rendered into a caller supplied buffer. Comma fields (%c %l %s) use a hand
+// written thousands grouping formatter, so no per row locale or printf setup is needed.
+//
+//   %<width>.<precision><field>
+//      e or n  extension or name
+//      c C     count, with or without thousands separator
+//      l L     hardlinks
+//      s S     size
+//      pNN PNN size at percentile NN (ex: %12p90), from the -histogram buckets
+//      h       non empty histogram buckets as <bucketLow>:<files> pairs
+//      aNN ANN size of files at least NN days old (ex: %15a90), from the -age buckets
+//      oNN ONN count of files at least NN days old
+//      m M     95% margin (+-) of the -estimate size, disk size if the plan's rows print it
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct DuInfo;
+struct SizeHist;
+
+//-------------------------------------------------------------------------------------------------
+class FormatPlan {
+public:
+    FormatPlan() : diskSize(false) {}
+
+    // nameOnly, any field prints the name (-CFMT column format).
+    void compile(const char* customFmt, bool nameOnly = false);
+    bool empty() const { return parts.empty(); }
+    // True if a field needs stat data (size or links).
+    bool needsStat() const;
+    // True if a field prints histogram data (percentile or buckets).
+    bool needsHist() const;
+    // True if a field prints age buckets.
+    bool needsAge() const;
+    // Rows pass disk size as their size, so margin fields show the disk size margin.
+    void setDiskSize(bool _diskSize) { diskSize = _diskSize; }
+
+    // Append row to out, histogram, age and margin fields are blank without detail.
+    void render(std::string& out, const char* name, size_t count, size_t links, size_t size,
+        const DuInfo* detail = nullptr) const;
+
+    // Thousands separator for comma fields, from the C locale's LC_NUMERIC or ','.
+    static void initGrouping();
+
+private:
+    enum Field { LITERAL, NAME, COUNT, LINKS, SIZE, PERCENTILE, BUCKETS, AGE_SIZE, AGE_COUNT, MARGIN };
+    struct Part {
+        Field field;
+        bool group;         // thousands separator
+        bool left;          // '-' flag
+        bool zeroPad;       // '0' flag
+        int width;
+        int precision;      // -1 if none
+        unsigned arg;       // PERCENTILE percent, AGE_SIZE and AGE_COUNT days
+        std::string text;   // literal text, or printf spec for NAME and plain numbers
+    };
+
+    static void appendNumber(std::string& out, const Part& part, size_t value);
+    static void appendBuckets(std::string& out, const SizeHist& hist);
+
+    std::vector<Part> parts;
+    bool diskSize;
+};
@@ -0,0 +1,236 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "globmatch.hpp"
+
+#include <string.h>
+
+static inline char lowerAscii(char chr) {
+    return (chr >= 'A' && chr <= 'Z') ? (char)(chr - 'A' + 'a') : chr;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool GlobPattern::compile(const char* pattern, bool isRegex, bool icase) {
+    chars.clear();
+    ops.clear();
+    ignoreCase = icase;
+
+    for (const char* ptr = pattern; *ptr != '\0'; ptr++) {
+        char chr = *ptr;
+        if ((unsigned char)chr >= 0x80 && icase)
+            return false;       // locale dependent case folding, leave to regex
+        if (chr == '\n' || chr == '\r')
+            return false;
+
+        if (!isRegex) {
+            // DOS pattern, ParseUtil converts * to .*, ? to . and . to [.], rest is regex.
+            if (chr == '*') {
+                ops.push_back(OP_STAR);
+                chars += '\0';
+                continue;
+            } else if (chr == '?') {
+                ops.push_back(OP_ANY);
+                chars += '\0';
+                continue;
+            } else if (chr == '.') {
+                ops.push_back(OP_CHAR);
+                chars += '.';
+                continue;
+            }
+        } else {
+            // Plain regex forms: .*  .  [c]  \<punct>
+            bool literal = false;
+            if (chr == '.') {
+                if (ptr[1] == '*') {
+                    ops.push_back(OP_STAR);
+                    ptr++;
+                } else {
+                    ops.push_back(OP_ANY);
+                }
+                chars += '\0';
+                continue;
+            } else if (chr == '[' && ptr[1] != '\0' && strchr("^\\]", ptr[1]) == nullptr && ptr[2] == ']') {
+                chr = ptr[1];
+                ptr += 2;
+                literal = true;
+            } else if (chr == '\\') {
+                if (ptr[1] == '\0' || strchr("\\^$.|?*+()[]{}/-", ptr[1]) == nullptr)
+                    return false;   // class escape (\d \w \b ...)
+                chr = *++ptr;
+                literal = true;
+            }
+            if (ptr[1] == '*' || ptr[1] == '+' || ptr[1] == '?' || ptr[1] == '{')
+                return false;       // quantified literal
+            if (literal) {
+                ops.push_back(OP_CHAR);
+                chars += icase ? lowerAscii(chr) : chr;
+                continue;
+            }
+        }
+
+        if (strchr("\\^$|?*+()[]{}", chr) != nullptr)
+            return false;       // other regex syntax
+        ops.push_back(OP_CHAR);
+        chars += icase ? lowerAscii(chr) : chr;
+    }
+
+    minLen = 0;
+    tailLen = 0;
+    hasStar = false;
+    for (Op op : ops) {
+        if (op == OP_STAR) {
+            hasStar = true;
+            tailLen = 0;
+        } else {
+            minLen++;
+            tailLen = (op == OP_CHAR) ? tailLen + 1 : 0;
+        }
+    }
+    if (!hasStar)
+        tailLen = 0;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool GlobPattern::matches(std::string_view str) const {
+    size_t strLen = str.length();
+    if (strLen < minLen || (!hasStar && strLen != minLen))
+        return false;
+    // Wildcards never match a line break, as regex '.'
+    if (strLen != 0 && (memchr(str.data(), '\n', strLen) != nullptr || memchr(str.data(), '\r', strLen) != nullptr))
+        return false;
+
+    // Literal text after the last '*', ex: the ".txt" of "*.txt"
+    const char* patChr = chars.data();
+    const char* strChr = str.data();
+    size_t patEnd = ops.size();
+    if (tailLen != 0) {
+        const char* patTail = patChr + patEnd - tailLen;
+        const char* strTail = strChr + strLen - tailLen;
+        for (size_t idx = 0; idx < tailLen; idx++) {
+            char chr = ignoreCase ? lowerAscii(strTail[idx]) : strTail[idx];
+            if (chr != patTail[idx])
+                return false;
+        }
+        patEnd -= tailLen;
+        strLen -= tailLen;
+    }
+
+    // Glob walk, backtrack only to the most recent '*'
+    size_t pIdx = 0;
+    size_t sIdx = 0;
+    size_t starP = std::string::npos;
+    size_t starS = 0;
+    while (sIdx < strLen) {
+        if (pIdx < patEnd) {
+            Op op = ops[pIdx];
+            if (op == OP_STAR) {
+                starP = pIdx++;
+                starS = sIdx;
+                continue;
+            }
+            char chr = strChr[sIdx];
+            if (op == OP_ANY || (ignoreCase ? lowerAscii(chr) : chr) == patChr[pIdx]) {
+                pIdx++;
+                sIdx++;
+                continue;
+            }
+        }
+        if (starP == std::string::npos)
+            return false;
+        pIdx = starP + 1;
+        sIdx = ++starS;
+    }
+    while (pIdx < patEnd && ops[pIdx] == OP_STAR)
+        pIdx++;
+    return pIdx == patEnd;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Run the pattern as an NFA over prefix, states are op positions still possible.
+GlobPattern::PrefixMatch GlobPattern::matchPrefix(std::string_view prefix) const {
+    size_t opCnt = ops.size();
+    std::vector<char> states(opCnt + 1, 0);
+    std::vector<char> next(opCnt + 1, 0);
+    auto closure = [this, opCnt](std::vector<char>& set) {
+        for (size_t idx = 0; idx < opCnt; idx++) {
+            if (set[idx] && ops[idx] == OP_STAR)
+                set[idx + 1] = 1;
+        }
+    };
+
+    states[0] = 1;
+    closure(states);
+    for (char chr : prefix) {
+        if (chr == '\n' || chr == '\r')
+            return PREFIX_NONE;
+        if (ignoreCase)
+            chr = lowerAscii(chr);
+        std::fill(next.begin(), next.end(), 0);
+        bool live = false;
+        for (size_t idx = 0; idx < opCnt; idx++) {
+            if (!states[idx])
+                continue;
+            if (ops[idx] == OP_STAR)
+                next[idx] = 1;
+            else if (ops[idx] == OP_ANY || chars[idx] == chr)
+                next[idx + 1] = 1;
+            else
+                continue;
+            live = true;
+        }
+        if (!live)
+            return PREFIX_NONE;
+        closure(next);
+        states.swap(next);
+    }
+
+    // A state before the end is needed to consume the non-empty rest.
+    PrefixMatch result = PREFIX_NONE;
+    for (size_t idx = 0; idx < opCnt; idx++) {
+        if (!states[idx])
+            continue;
+        size_t end = idx;
+        while (end < opCnt && ops[end] == OP_STAR)
+            end++;
+        if (end == opCnt && ops[idx] == OP_STAR)
+            return PREFIX_ALL;  // only '*' left
+        result = PREFIX_SOME;
+    }
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool MatchList::matches(std::string_view str, bool emptyResult) const {
+    if (empty() || str.empty())
+        return emptyResult;
+    for (const GlobPattern& glob : globs) {
+        if (glob.matches(str))
+            return true;
+    }
+    for (const std::regex& regex : regexes) {
+        if (std::regex_match(str.begin(), str.end(), regex))
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool MatchList::noneMatchPrefix(std::string_view prefix) const {
+    if (!regexes.empty())
+        return false;
+    for (const GlobPattern& glob : globs) {
+        if (glob.matchPrefix(prefix) != GlobPattern::PREFIX_NONE)
+            return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool MatchList::allMatchPrefix(std::string_view prefix) const {
+    for (const GlobPattern& glob : globs) {
+        if (glob.matchPrefix(prefix) == GlobPattern::PREFIX_ALL)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Fast matcher for the default DOS style patterns (* ? .) used by the include/exclude options.
+//
+// ParseUtil turns a DOS pattern into a std::regex (* to .*, ? to ., . to [.]) and runs
+// regex_match on every directory entry. GlobPattern compiles the same pattern into a short
+// op list matched with a linear backtracking glob walk, and checks the literal text after
+// the last '*' first so most names are rejected with one compare.
+// Patterns using other regex syntax keep the std::regex, MatchList holds both kinds.
+//
+// matchPrefix() tells if a pattern can match, or always matches, paths below a directory,
+// so the scan can skip subtrees which -IncludePath or -ExcludePath would filter out.
+
+#pragma once
+
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class GlobPattern {
+public:
+    // Compile pattern, isRegex when given with -regex.
+    // Returns false if the pattern needs regex features the glob matcher can not express.
+    bool compile(const char* pattern, bool isRegex, bool ignoreCase);
+
+    // Same result as std::regex_match on the equivalent regex.
+    bool matches(std::string_view str) const;
+
+    enum PrefixMatch { PREFIX_NONE, PREFIX_SOME, PREFIX_ALL };
+    // Classify strings prefix + <non-empty rest>: none can match, some may, or all match.
+    PrefixMatch matchPrefix(std::string_view prefix) const;
+
+private:
+    enum Op : char { OP_CHAR, OP_ANY, OP_STAR };
+
+    std::string chars;          // literal for OP_CHAR, lower case if ignoreCase
+    std::vector<Op> ops;
+    size_t minLen = 0;          // count of non-star ops
+    size_t tailLen = 0;         // literal chars after last '*'
+    bool hasStar = false;
+    bool ignoreCase = false;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Pattern list, same semantics as ParseUtil::FileMatches on a PatternList.
+class MatchList {
+public:
+    std::vector<GlobPattern> globs;
+    std::vector<std::regex> regexes;
+
+    bool empty() const { return globs.empty() && regexes.empty(); }
+    bool matches(std::string_view str, bool emptyResult) const;
+
+    // True if no string starting with prefix can match, false if unsure (regex in list).
+    bool noneMatchPrefix(std::string_view prefix) const;
+    // True if every string starting with prefix matches.
+    bool allMatchPrefix(std::string_view prefix) const;
+};
@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "inodeset.hpp"
+
+//-------------------------------------------------------------------------------------------------
+// splitmix64 finalizer, spreads sequential inode numbers over the table.
+static inline unsigned long long hashInode(unsigned long long dev, unsigned long long ino) {
+    unsigned long long hash = ino ^ (dev * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+//-------------------------------------------------------------------------------------------------
+InodeSet::InodeSet() {
+}
+
+//-------------------------------------------------------------------------------------------------
+bool InodeSet::insert(unsigned long long dev, unsigned long long ino) {
+    if (ino == 0)
+        return true;    // cannot be tracked, count it
+    unsigned long long hash = hashInode(dev, ino);
+    Shard& shard = shards[hash >> (64 - SHARD_BITS)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if ((shard.used + 1) * 10 > shard.slots.size() * 7)
+        grow(shard);
+    if (!insertSlot(shard.slots, hash, dev, ino))
+        return false;
+    shard.used++;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+size_t InodeSet::size() const {
+    size_t count = 0;
+    for (const Shard& shard : shards)
+        count += shard.used;
+    return count;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool InodeSet::insertSlot(std::vector<Slot>& slots, unsigned long long hash, unsigned long long dev, unsigned long long ino) {
+    size_t mask = slots.size() - 1;
+    for (size_t idx = hash & mask; ; idx = (idx + 1) & mask) {
+        Slot& slot = slots[idx];
+        if (slot.ino == 0) {
+            slot.dev = dev;
+            slot.ino = ino;
+            return true;
+        }
+        if (slot.ino == ino && slot.dev == dev)
+            return false;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void InodeSet::grow(Shard& shard) {
+    std::vector<Slot> slots(shard.slots.empty() ? 256 : shard.slots.size() * 2, Slot{0, 0});
+    for (const Slot& slot : shard.slots) {
+        if (slot.ino != 0)
+            insertSlot(slots, hashInode(slot.dev, slot.ino), slot.dev, slot.ino);
+    }
+    shard.slots.swap(slots);
+}
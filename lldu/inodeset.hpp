@@ -0,0 +1,40 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Set of (st_dev, st_ino) pairs used by -unique to count each hard linked inode once.
+//
+// Open addressing with linear probing, 16 bytes per slot and at most 70% full, so memory
+// stays near 23 bytes per tracked inode. Only files with nlink > 1 are inserted.
+// Split into independently locked shards so parallel scan workers rarely contend.
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class InodeSet {
+public:
+    InodeSet();
+
+    // Returns true if (dev, ino) was not already in the set.
+    bool insert(unsigned long long dev, unsigned long long ino);
+    size_t size() const;
+
+private:
+    struct Slot {
+        unsigned long long dev;
+        unsigned long long ino;     // 0 marks an empty slot, no real file has inode 0
+    };
+    struct Shard {
+        std::mutex lock;
+        std::vector<Slot> slots;    // power of 2 size
+        size_t used;
+        Shard() : used(0) {}
+    };
+    static const unsigned SHARD_BITS = 6;
+
+    static void grow(Shard& shard);
+    static bool insertSlot(std::vector<Slot>& slots, unsigned long long hash, unsigned long long dev, unsigned long long ino);
+
+    Shard shards[1 << SHARD_BITS];
+};
@@ -42,6 +42,21 @@
 #include "parseutil.hpp"
 #include "directory.hpp"
 #include "storage.hpp"
+#include "workpool.hpp"
+#include "dirscan.hpp"
+#include "uringstat.hpp"
+#include "inodeset.hpp"
+#include "globmatch.hpp"
+#include "dulist.hpp"
+#include "progress.hpp"
+#include "formatplan.hpp"
+#include "outsink.hpp"
+#include "snapshot.hpp"
+#include "snapdiff.hpp"
+#include "watcher.hpp"
+#include "dirtree.hpp"
+#include "topn.hpp"
+#include "owners.hpp"
 
 #include <assert.h>
 #include <fstream>
@@ -51,6 +66,13 @@
 #include <algorithm>
 #include <regex>
 #include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <random>
+#include <atomic>
+#include <chrono>
 
 #define _POSIX_C_SOURCE 200809L
 
@@ -80,12 +102,18 @@ struct PickPat {
 };
 typedef std::vector<PickPat> PickPatList;
 
+// -pick results are cached by the name's suffix after its last dot when every pick
+// pattern only depends on that suffix, see suffixOnlyPick().
+static bool pickBySuffix = true;
+static unsigned pickMinRest = 0;    // chars after last dot needed for the key to be valid
+const size_t MAX_PICK_CACHE = 4096;
+
 // Runtime options
-static PatternList includeFilePatList;
-static PatternList excludeFilePatList;
-static PatternList includeDirPatList;
-static PatternList excludeDirPatList;
-static PatternList summaryDirPatList;
+static MatchList includeFilePatList;
+static MatchList excludeFilePatList;
+static MatchList includeDirPatList;
+static MatchList excludeDirPatList;
+static MatchList summaryDirPatList;
 static PickPatList pickPatList;
 static StringList fileDirList;
 
@@ -103,26 +131,109 @@ static bool showAbsPath = false;    // -absolute = show absolute path.
 static bool total = false;
 static bool dryrun = false;
 static bool divByHardlink = false;
+static bool uniqueInodes = false;   // -unique, count hard linked inode's size once
+static InodeSet inodeSet;
 static bool progress = false;
 static bool listDev = false;
-static size_t progressLen = 0;
+const unsigned PROGRESS_SEC = 10;    // -progress report interval
+static unsigned threadCnt = 1;      // -threads=N, 1 is serial scan
+static bool needStat = true;        // false if output only needs counts, see setNeedStat()
+static unsigned statNeed = DirScan::NEED_TYPE | DirScan::NEED_SIZE | DirScan::NEED_LINKS;
+static bool useUring = false;       // -engine=uring, batch statx per directory
+static bool canPrune = false;       // skip subtrees path patterns filter out, see setCanPrune()
+static lstring snapshotFile;        // -snapshot=<file>, reuse totals of unchanged directories
+static std::string snapOptions;     // options which change the totals, keys the snapshot
+static bool useSnapshot = false;    // see setUseSnapshot()
+static lstring fromSnapshotFile;    // -from-snapshot=<file>, report from snapshot, no filesystem access
+static lstring diffSnapshotFile;    // -diff=<old> <new>, growth between two snapshots
+const size_t DIFF_ROWS = 50;        // directories listed by -diff
+static unsigned watchSec = 0;       // -watch[=seconds] report interval, 0 is off
+const unsigned WATCH_SEC = 10;
+static unsigned depthReport = 0;    // -depth-report=N stored as N+1, 0 is off
+static DirTree dirTree;             // -depth-report directory totals
+static unsigned topCount = 0;       // -top=N[,disk] largest files and directories
+static bool topByDisk = false;
+static FormatPlan topPlan;
+static bool sizeHistogram = false;  // -histogram or %p %h format fields, size buckets per ext
+static char ageBy = 0;              // -age=mtime|atime, 'm' or 'a', age buckets per ext
+enum GroupBy { GROUP_EXT, GROUP_UID, GROUP_GID, GROUP_EXT_UID };
+static GroupBy groupBy = GROUP_EXT; // -group=uid|gid|ext+uid, report key
+static bool xdev = false;           // -xdev, do not cross into other filesystems
+static unsigned long long rootDev = 0;  // -xdev device of the argument being scanned
+static bool byDevice = false;       // -by-device, totals per st_dev
+static FormatPlan devPlan;
+static double estimateRate = 0;     // -estimate=<fraction> of files stat'ed, 0 is off
+static uint64_t sampleSeed = 0;     // -seed=N, else random
+static bool hasSeed = false;
+static uint64_t sampleLimit = 0;    // file is sampled if its hash is below
+static unsigned deadlineSec = 0;    // -deadline=<seconds> scan budget, 0 is off
+static std::chrono::steady_clock::time_point deadlineAt;
+static std::atomic<bool> deadlineHit(false);
+static std::vector<std::string> deadlineSkipped;   // subtrees not scanned, guarded by scanMutex
+const size_t DEADLINE_LIST = 50;    // skipped subtrees listed by the coverage report
+static SnapshotReader snapReader;
+static SnapshotWriter snapWriter;
 
 const size_t MAX_DIR_DEPTH = 200;
 
-struct DuInfo {
-    std::string ext;
-    size_t count;
-    size_t diskSize;
-    size_t fileSize;
-    size_t hardlinks;
-    size_t softlinks;
-    DuInfo() : count(0), diskSize(0), fileSize(0), hardlinks(0), softlinks(0) {}
-    DuInfo(std::string _str, size_t _count, size_t _diskSize, size_t _fileSize, size_t _links ) :
-        ext(_str), count(_count), diskSize(_diskSize), fileSize(_fileSize), hardlinks(_links) {}
+DuList duList;
+
+// -top, a directory whose subtree is still being scanned. pending counts the directory's own
+// scan, its running subdirectory scans and queued pool tasks which will scan a subdirectory.
+// The last to finish ranks the subtree total, adds it to the parent and frees the entry, so
+// only directories in progress are held.
+struct TopDir {
+    TopDir* parent;
+    std::atomic<unsigned> pending;
+    std::atomic<uint64_t> size;
+    std::string path;
+
+    TopDir(TopDir* _parent, const std::string& _path) : parent(_parent), pending(1), size(0), path(_path) {}
 };
 
-typedef std::map<std::string, DuInfo> DuList;
-DuList duList;
+// Per-worker scan state, the serial scan uses mainCtx which aggregates into global duList.
+struct ScanCtx {
+    DuList ownList;
+    DuList& duList;
+    size_t fileCount;
+    unsigned worker;
+    WorkPool* pool;     // non-null while scanning inside a parallel unit
+    std::unique_ptr<UringStat> uring;
+    std::unordered_map<std::string, std::string> pickCache;   // suffix key, picked ext
+    std::string pickKey;
+    std::string pickExt;
+    size_t progressFiles;   // counts not yet handed to Progress
+    size_t progressBytes;
+    DuList* dirOwn;         // current directory's own files, recorded for -snapshot
+    DuSums* dirSums;        // current directory's own totals, for -depth-report
+    uint32_t dirNode;       // current directory's DirTree node
+    TopList topFiles;       // -top, largest files and directories seen by this context
+    TopList topDirs;
+    TopDir* topDir;         // current directory's -top entry
+    size_t dirsVisited;     // -deadline coverage
+    OwnerNames owners;      // -group, names of owner ids seen by this context
+    std::string groupKey;   // -group=ext+uid key
+    std::unordered_map<unsigned long long, DuSums> devSums;     // -by-device, per st_dev
+    unsigned long long lastDev;
+    DuSums* lastDevSums;    // devSums entry of lastDev, files of a dir share a device
+
+    ScanCtx() : duList(ownList), fileCount(0), worker(WorkPool::NOT_WORKER), pool(nullptr),
+        progressFiles(0), progressBytes(0), dirOwn(nullptr), dirSums(nullptr), dirNode(DirTree::NO_NODE),
+        topDir(nullptr), dirsVisited(0), lastDev(0), lastDevSums(nullptr) {}
+    ScanCtx(DuList& _duList) : duList(_duList), fileCount(0), worker(WorkPool::NOT_WORKER), pool(nullptr),
+        progressFiles(0), progressBytes(0), dirOwn(nullptr), dirSums(nullptr), dirNode(DirTree::NO_NODE),
+        topDir(nullptr), dirsVisited(0), lastDev(0), lastDevSums(nullptr) {}
+
+    UringStat& uringStat() {
+        if (!uring)
+            uring.reset(new UringStat());
+        return *uring;
+    }
+};
+static ScanCtx mainCtx(duList);
+static WorkPool* workPool = nullptr;
+static std::vector<std::unique_ptr<ScanCtx>> workerCtxs;
+static std::mutex scanMutex;        // guards shared output and fileNameList while parallel
 
 typedef int (*SortByFunc)(const DuInfo& lhs, const DuInfo& rhs);
 struct SortBy {
@@ -146,86 +257,238 @@ SortBy* sortBy = nullptr;
 
 std::string separator = "\t";
 std::string formatDef = "%8.8e\t%8c\t%15s\n";        // %s\t%8d\t%15d\n";
-std::string header = "     Ext\t   Count\t      Size\n";
+const char* DEF_HEADER = "     Ext\t   Count\t      Size\n";
+std::string header = DEF_HEADER;
 std::string tformat = formatDef;
 // std::string sformat = "%10S %n\n";
 std::string sformat = "%15s Files:%5c \t HardLinks:%3l\t%n \n";
 std::string cformat = "%15.15s\t";  // 1st column name format
+static FormatPlan formatPlan;       // formatDef, tformat, sformat and cformat compiled once
+static FormatPlan totalPlan;
+static FormatPlan summaryPlan;
+static FormatPlan columnPlan;
 
 int setBothFmt = 0;
-time_t startT, prevT;
+time_t startT;
 
 // Forward declaration
 void printTime(time_t epoch, const char* fmtTm);
 void clearUsage();
 void printUsage(const std::string& filepath);
+void printParts(const FormatPlan& plan, const char* name, size_t count, size_t links, size_t size,
+    const DuInfo* detail = nullptr);
 void buildTable(const std::string& filepath);
 void printTable();
+void printWatch(const Watcher& watcher);
+void printDepthReport();
+void printTop();
+void printDevices();
+void printCoverage();
 
 static char CWD_BUF[MAX_PATH];
 static unsigned CWD_LEN = 0;
 
 //-------------------------------------------------------------------------------------------------
 void clearProgress() {
-    if (progressLen > 0)
-        printf("%*s\r", (int)progressLen, "");
-    progressLen = 0;
+    if (progress)
+        Progress::clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Full path of directory's current entry, built on first use.
+static inline
+const lstring& entryPath(const DirScan* directory, lstring& fullname) {
+    if (fullname.empty())
+        directory->fullName(fullname);
+    return fullname;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Run -pick patterns, first whole name match is formatted with its toStr in one regex pass.
+static
+void runPick(std::string_view filename, std::string& ext) {
+    std::match_results<std::string_view::const_iterator> smatch;
+    ext.clear();
+    for (const PickPat& pick : pickPatList) {
+        if (std::regex_match(filename.begin(), filename.end(), smatch, pick.fromPat)) {
+            smatch.format(std::back_inserter(ext), pick.toStr);
+            break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Picked extension of filename, memoized per scan context by suffix when patterns allow.
+static
+std::string_view pickExt(ScanCtx& ctx, std::string_view filename) {
+    if (pickBySuffix && filename.find_first_of("\n\r") == std::string_view::npos) {
+        // Key is [0|1 chars before last dot][suffix after last dot], or empty if no dot.
+        size_t dot = filename.rfind('.');
+        if (dot == std::string_view::npos) {
+            ctx.pickKey.clear();
+        } else if (filename.length() - dot - 1 >= pickMinRest) {
+            ctx.pickKey.assign(1, (dot == 0) ? '0' : '1');
+            ctx.pickKey.append(filename.substr(dot + 1));
+        } else {
+            runPick(filename, ctx.pickExt);
+            return ctx.pickExt;
+        }
+
+        auto iter = ctx.pickCache.find(ctx.pickKey);
+        if (iter != ctx.pickCache.end())
+            return iter->second;
+        if (ctx.pickCache.size() >= MAX_PICK_CACHE)
+            ctx.pickCache.clear();
+        runPick(filename, ctx.pickExt);
+        return ctx.pickCache.emplace(ctx.pickKey, ctx.pickExt).first->second;
+    }
+
+    runPick(filename, ctx.pickExt);
+    return ctx.pickExt;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -group report key, owner name or ext:owner. Names come from the context's id cache.
+static
+std::string_view groupKey(ScanCtx& ctx, std::string_view ext, const FileStat& filestat) {
+    switch (groupBy) {
+    case GROUP_UID:
+        return ctx.owners.user(filestat.uid);
+    case GROUP_GID:
+        return ctx.owners.group(filestat.gid);
+    default:
+        ctx.groupKey.assign(ext);
+        ctx.groupKey += ':';
+        ctx.groupKey += ctx.owners.user(filestat.uid);
+        return ctx.groupKey;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// -estimate, pick files by a hash of seed, directory and name. Same seed, same sample,
+// whatever the thread count or directory order.
+static
+bool inSample(const DirScan& directory, std::string_view filename) {
+    uint64_t hash = sampleSeed ^ 14695981039346656037ULL;
+    for (char chr : std::string_view(directory.path()))
+        hash = (hash ^ (unsigned char)chr) * 1099511628211ULL;
+    hash = (hash ^ '/') * 1099511628211ULL;
+    for (char chr : filename)
+        hash = (hash ^ (unsigned char)chr) * 1099511628211ULL;
+    // splitmix64 finalizer, FNV low bits alone are not uniform enough
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash < sampleLimit;
 }
 
 //-------------------------------------------------------------------------------------------------
 // Open, read and parse file.
+// directory is null for a file named on the command line (filepath set), else the file is
+// directory's current entry and is stat'ed relative to the directory fd.
+// When only counts are reported (needStat false) and readdir supplied the type, skip stat.
+// With -estimate files outside the sample are only counted, the same way.
 static
-bool ExamineFile(const lstring& filepath, const lstring& filename) {
-    struct stat filestat;
-    // Use lstat to avoid following the link to its target
-    if (lstat(filepath, &filestat) != 0)
+bool ExamineFile(ScanCtx& ctx, const DirScan* directory, lstring& filepath, std::string_view filename) {
+    FileStat filestat;
+    DirScan::Type type = (directory != nullptr) ? directory->type() : DirScan::TYPE_UNKNOWN;
+    bool sampled = (sampleLimit == 0 || directory == nullptr || type == DirScan::TYPE_UNKNOWN
+        || inSample(*directory, filename));
+    if ((!needStat || !sampled) && type != DirScan::TYPE_UNKNOWN) {
+        memset(&filestat, 0, sizeof(filestat));
+        filestat.nlink = 1;
+#ifdef HAVE_WIN
+        filestat.mode = S_IFREG;
+#else
+        filestat.mode = (type == DirScan::TYPE_LINK) ? S_IFLNK : S_IFREG;
+#endif
+    } else if (directory != nullptr) {
+        if (!directory->stat(filestat, statNeed))
+            return false;
+    } else if (!DirScan::statPath(filepath, filestat, statNeed)) {
         return false;
+    }
 
-    lstring ext;
+    lstring extBuf;
+    std::string_view ext;
     if (pickPatList.empty()) {
-        DirUtil::getExt(ext, filename);
-    } else  {
-        std::smatch smatch;
-        PickPatList::const_iterator iter;
-        for (iter = pickPatList.cbegin(); iter != pickPatList.cend(); iter++) {
-            regex_constants::match_flag_type flags = regex_constants::match_default;
-            // tmpName = regex_replace(tmpName, iter->fromPat, iter->toStr, flags);
-
-            if (std::regex_match(filename, smatch, iter->fromPat)) {
-                // size_t pos = smatch.position();
-                // size_t len = smatch[0].length();
-                ext = regex_replace(filename, iter->fromPat, iter->toStr, flags);
-                break;
-            }
-        }
+        DirUtil::getExt(extBuf, lstring(filename.data(), filename.length()));
+        ext = extBuf;
+    } else {
+        ext = pickExt(ctx, filename);
+    }
+    if (groupBy != GROUP_EXT)
+        ext = groupKey(ctx, ext, filestat);
+
+    DuSums duInfo;
+    duInfo.count = 1;
+    ctx.progressFiles++;
+    ctx.progressBytes += filestat.size;
+
+    if (!sampled) {
+        if (S_ISLNK(filestat.mode))
+            duInfo.softlinks = 1;
+        ctx.duList[ext] += duInfo;
+        return true;
     }
-
-    DuInfo& duInfo = duList[ext];
-    duInfo.ext = ext;
-    duInfo.count++;
 
 #ifdef HAVE_WIN
-    size_t diskSize = filestat.st_size;    // filestat.st_size;
+    size_t diskSize = filestat.size;    // filestat.st_size;
 #else
-    size_t diskSize = filestat.st_blocks * filestat.st_blksize;
+    size_t diskSize = filestat.blocks * filestat.blksize;
 #endif
 
-    if (filestat.st_nlink > 1)
-        duInfo.hardlinks++;
-    if (S_ISLNK(filestat.st_mode))
-        duInfo.softlinks++;
-    else {
-        if (filestat.st_nlink > 1 && divByHardlink) {
-            duInfo.diskSize += diskSize / filestat.st_nlink;
-            duInfo.fileSize += filestat.st_size / filestat.st_nlink;
+    if (filestat.nlink > 1)
+        duInfo.hardlinks = 1;
+    if (S_ISLNK(filestat.mode))
+        duInfo.softlinks = 1;
+    else if (filestat.nlink > 1 && uniqueInodes) {
+        if (inodeSet.insert(filestat.dev, filestat.ino)) {
+            duInfo.diskSize = diskSize;
+            duInfo.fileSize = filestat.size;
+        }
+    } else {
+        if (filestat.nlink > 1 && divByHardlink) {
+            duInfo.diskSize = diskSize / filestat.nlink;
+            duInfo.fileSize = filestat.size / filestat.nlink;
         } else {
-            duInfo.diskSize += diskSize;
-            duInfo.fileSize += filestat.st_size;
+            duInfo.diskSize = diskSize;
+            duInfo.fileSize = filestat.size;
+        }
+    }
+
+    ctx.duList[ext] += duInfo;
+    if (ctx.dirOwn != nullptr)
+        (*ctx.dirOwn)[ext] += duInfo;
+    if (ctx.dirSums != nullptr)
+        *ctx.dirSums += duInfo;
+    if (byDevice) {
+        if (ctx.lastDevSums == nullptr || ctx.lastDev != filestat.dev) {
+            ctx.lastDev = filestat.dev;
+            ctx.lastDevSums = &ctx.devSums[filestat.dev];
         }
+        *ctx.lastDevSums += duInfo;
+    }
+    if (sizeHistogram && !S_ISLNK(filestat.mode))
+        ctx.duList.histogram(ext).add(filestat.size);
+    if (sampleLimit != 0 && !S_ISLNK(filestat.mode))
+        ctx.duList.estimates(ext).add(duInfo.fileSize, duInfo.diskSize);
+    if (ageBy != 0 && !S_ISLNK(filestat.mode))
+        ctx.duList.ages(ext).add((int64_t)startT - (ageBy == 'a' ? filestat.atime : filestat.mtime), duInfo.fileSize);
+    if (topCount != 0 && !S_ISLNK(filestat.mode)) {
+        size_t topValue = topByDisk ? diskSize : filestat.size;
+        if (ctx.topFiles.wants(topValue))
+            ctx.topFiles.add(topValue, entryPath(directory, filepath));
     }
     
     if (verbose) {
-        std::cout << "File:" << filepath << " DiskSize:" << diskSize << " FileSize:" << filestat.st_size << " HardLinks:" << filestat.st_nlink << std::endl;
+        std::unique_lock<std::mutex> lock(scanMutex, std::defer_lock);
+        if (ctx.pool != nullptr)
+            lock.lock();
+        OutSink::print("File:%s DiskSize:%zu FileSize:%zu HardLinks:%zu\n",
+            entryPath(directory, filepath).c_str(), diskSize, filestat.size, filestat.nlink);
     }
     return true;
 }
@@ -233,41 +496,52 @@ bool ExamineFile(const lstring& filepath, const lstring& filename) {
 
 //-------------------------------------------------------------------------------------------------
 // Locate matching files which are not in exclude list.
+// directory is null for a file named on the command line (fullname set), else the file is
+// directory's current entry and fullname is only built if patterns or output need it.
+// name points into the directory read buffer, an lstring copy is only made for patterns.
 static
-size_t FindFile(const lstring& fullname, unsigned depth) {
+size_t FindFile(ScanCtx& ctx, const DirScan* directory, std::string_view name, lstring& fullname, unsigned depth) {
     size_t fileCount = 0;
-    lstring name;
-    DirUtil::getName(name, fullname);
+    std::unique_lock<std::mutex> lock(scanMutex, std::defer_lock);
 
     if (! name.empty()
-            && !ParseUtil::FileMatches(fullname, excludeDirPatList, false)
-            && ParseUtil::FileMatches(fullname, includeDirPatList, true)
-            && !ParseUtil::FileMatches(name, excludeFilePatList, false)
-            && ParseUtil::FileMatches(name, includeFilePatList, true)) {
-        if (ExamineFile(fullname, name)) {
+            && (excludeDirPatList.empty() || !excludeDirPatList.matches(entryPath(directory, fullname), false))
+            && (includeDirPatList.empty() || includeDirPatList.matches(entryPath(directory, fullname), true))
+            && !excludeFilePatList.matches(name, false)
+            && includeFilePatList.matches(name, true)) {
+        if (ExamineFile(ctx, directory, fullname, name)) {
             fileCount++;    // includes soft links (size is ignored for soft links)
-            if (showFile)
-                std::cout << fullname << std::endl;
+            if (showFile) {
+                if (ctx.pool != nullptr)
+                    lock.lock();
+                OutSink::write(entryPath(directory, fullname));
+                OutSink::put('\n');
+            }
         } else {
             int e = errno;
+            if (ctx.pool != nullptr)
+                lock.lock();
             if (e == EINVAL) {
-                cerr << "Invalid " << fullname << std::endl;
+                cerr << "Invalid " << entryPath(directory, fullname) << std::endl;
             } else if (e == ENOENT) {
-                cerr << "Special characters or no permission to: " << fullname << std::endl;
+                cerr << "Special characters or no permission to: " << entryPath(directory, fullname) << std::endl;
             }
         }
 
         if (isSideBySide) {
+            if (ctx.pool != nullptr && !lock.owns_lock())
+                lock.lock();
             if (depth == 0)
-                fileNameList.insert(name);
+                fileNameList.insert(std::string(name));
             else {
+                entryPath(directory, fullname);
                 size_t off = fullname.length(); 
                 int dirParts = depth + 1;
                 while (dirParts-- > 0 && off != string::npos) {
                     off = fullname.rfind(Directory_files::SLASH_CHAR, off-1);
                 }
                 if (off == string::npos) 
-                    fileNameList.insert(name);
+                    fileNameList.insert(std::string(name));
                 else {
                     fileNameList.insert(fullname.substr(off+1));
                 }
@@ -278,19 +552,287 @@ size_t FindFile(const lstring& fullname, unsigned depth) {
     return fileCount;
 }
 
+//-------------------------------------------------------------------------------------------------
+static size_t ScanTree(ScanCtx& ctx, const lstring& dirname, unsigned depth, const DirScan* parent = nullptr);
+static size_t FindFiles(ScanCtx& ctx, const lstring& dirname, unsigned depth, const DirScan* parent = nullptr);
+
+//-------------------------------------------------------------------------------------------------
+// True if no file below dirname can pass the -IncludePath / -ExcludePath filters in FindFile.
+static
+bool skipSubtree(const lstring& dirname) {
+    if (!canPrune || (includeDirPatList.empty() && excludeDirPatList.empty()))
+        return false;
+    lstring prefix = dirname;
+    prefix += Directory_files::SLASH_CHAR;
+    return (!includeDirPatList.empty() && includeDirPatList.noneMatchPrefix(prefix))
+        || excludeDirPatList.allMatchPrefix(prefix);
+}
+
+//-------------------------------------------------------------------------------------------------
+// -deadline, true once the scan budget is spent. Checked before each directory is entered,
+// the directory being read is always finished so its totals are complete.
+static
+bool pastDeadline() {
+    if (deadlineSec == 0)
+        return false;
+    if (deadlineHit.load(std::memory_order_relaxed))
+        return true;
+    if (std::chrono::steady_clock::now() < deadlineAt)
+        return false;
+    deadlineHit = true;
+    return true;
+}
+
+static
+void deadlineSkip(const std::string& dirname) {
+    std::lock_guard<std::mutex> lock(scanMutex);
+    deadlineSkipped.push_back(dirname);
+}
+
+//-------------------------------------------------------------------------------------------------
+// -top, one more pending count on dir, for a subdirectory scan or a pool task queued to run one.
+static
+TopDir* holdTopDir(TopDir* dir) {
+    if (dir != nullptr)
+        dir->pending++;
+    return dir;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -top, add size to dir and drop one pending count. A subtree which is now complete is ranked
+// in ctx.topDirs and its total is passed up to its parent.
+static
+void finishTopDir(ScanCtx& ctx, TopDir* dir, uint64_t size) {
+    while (dir != nullptr) {
+        dir->size += size;
+        if (--dir->pending != 0)
+            return;
+        size = dir->size;
+        if (ctx.topDirs.wants(size))
+            ctx.topDirs.add(size, dir->path);
+        TopDir* parent = dir->parent;
+        delete dir;
+        dir = parent;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Filter, report and recurse into subdirectory 'name' of a directory being scanned.
+// parent is the open directory positioned on the entry, or null to open fullname by path.
+static
+size_t scanSubdir(ScanCtx& ctx, const DirScan* parent, const lstring& name, const lstring& fullname,
+        unsigned depth, bool showTotals) {
+    size_t fileCount = 0;
+
+    if (isSideBySide) {
+        std::unique_lock<std::mutex> lock(scanMutex, std::defer_lock);
+        if (ctx.pool != nullptr)
+            lock.lock();
+        fileNameList.insert(name);
+    }
+
+    if ((maxDepth == 0 || depth+1 < maxDepth)
+            && (!dryrun || depth < 1)
+            && !excludeDirPatList.matches(fullname, false)
+        //    && includeDirPatList.matches(fullname, true)
+            && !excludeFilePatList.matches(name, false)
+        //    && includeFilePatList.matches(name, true)
+            && !skipSubtree(fullname)
+    ) {
+        if (verbose) {
+            std::unique_lock<std::mutex> lock(scanMutex, std::defer_lock);
+            if (ctx.pool != nullptr)
+                lock.lock();
+            OutSink::print("Dir:%s\n", fullname.c_str());
+        }
+
+        if (fullname.find_first_of('?') == string::npos) { 
+            if (summary && summaryDirPatList.matches(fullname, false)) {
+                clearUsage();
+            }
+            if (depth >= MAX_DIR_DEPTH) {
+                std::cerr << "Exceeded max directory depth " << MAX_DIR_DEPTH << std::endl;
+                std::cerr << fullname << std::endl;
+            } else if (pastDeadline()) {
+                deadlineSkip(fullname);
+            } else if (ctx.pool != nullptr) {
+                uint32_t dirNode = ctx.dirNode;
+                TopDir* topDir = holdTopDir(ctx.topDir);
+                ctx.pool->submit([fullname, depth, dirNode, topDir](unsigned worker) {
+                    ScanCtx& wctx = *workerCtxs[worker];
+                    wctx.dirNode = dirNode;
+                    wctx.topDir = topDir;
+                    if (pastDeadline())
+                        deadlineSkip(fullname);
+                    else if (!Signals::aborted)
+                        wctx.fileCount += FindFiles(wctx, fullname, depth + 1);
+                    finishTopDir(wctx, topDir, 0);
+                }, ctx.worker);
+            } else {
+                fileCount += ScanTree(ctx, fullname, depth + 1, parent);
+            }
+        }
+        else {
+            // '?' not valid part of file name path. 
+            std::cerr << "Invalid file name:" <<fullname << std::endl;
+        }
+
+        if (showTotals || summaryDirPatList.matches(fullname, false)) {
+            if (! isSideBySide) {
+                if (isTable) {
+                    buildTable(fullname);
+                } else { /* if (!total) */
+                    printUsage(fullname);
+                }
+            } 
+#ifdef HAVE_WIN
+            else if (depth == 0)
+                printUsage(fullname);
+#endif
+            clearUsage();
+        }
+    }
+    return fileCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Add a snapshot directory record's own file totals to ctx, and to snapDir when re-recording.
+static
+void addSnapExts(ScanCtx& ctx, const SnapDirRec& rec, SnapDir* snapDir) {
+    const SnapExtRec* exts = snapReader.exts(rec);
+    for (uint32_t idx = 0; idx < rec.extCnt; idx++) {
+        const SnapExtRec& ext = exts[idx];
+        DuSums sums;
+        sums.count = ext.count;
+        sums.diskSize = ext.diskSize;
+        sums.fileSize = ext.fileSize;
+        sums.hardlinks = ext.hardlinks;
+        sums.softlinks = ext.softlinks;
+        std::string_view name = snapReader.text(ext.nameOff, ext.nameLen);
+        ctx.duList[name] += sums;
+        if (ctx.dirSums != nullptr)
+            *ctx.dirSums += sums;
+        if (snapDir != nullptr)
+            snapDir->exts.emplace_back(std::string(name), sums);
+        ctx.progressBytes += ext.fileSize;
+    }
+    ctx.progressFiles += rec.fileCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -snapshot, directory is unchanged since the last scan: add its recorded totals and continue
+// with its recorded subdirectories, which are looked up in the snapshot in turn.
+// With -from-snapshot the totals are read straight from the mapped file and nothing is recorded.
+// directory is the open unchanged directory, subdirectories are opened relative to it, or null.
+static
+size_t replayDir(ScanCtx& ctx, const SnapDirRec& rec, const lstring& dirname, unsigned depth, const DirScan* directory) {
+    SnapDir snapDir;
+    if (useSnapshot) {
+        snapDir.path = dirname;
+        snapDir.dev = rec.dev;
+        snapDir.ino = rec.ino;
+        snapDir.mtime = rec.mtime;
+        snapDir.ctime = rec.ctime;
+        snapDir.fileCount = rec.fileCount;
+    }
+
+    if (progress)
+        Progress::setDir(dirname);
+
+    // -summary reports each top subdirectory as it completes, the root's own files go to the root's total.
+    // A live scan instead adds each root file to the row of the next subdirectory in readdir
+    // order, which the snapshot does not record, so replayed -summary rows can differ.
+    bool showTotals = summary && (depth == 0);
+    if (!showTotals)
+        addSnapExts(ctx, rec, useSnapshot ? &snapDir : nullptr);
+
+    size_t fileCount = rec.fileCount;
+    const SnapSubRec* subdirs = snapReader.subdirs(rec);
+    lstring name;
+    lstring fullname;
+    for (uint32_t idx = 0; idx < rec.subCnt && !Signals::aborted; idx++) {
+        name.assign(snapReader.text(subdirs[idx].nameOff, subdirs[idx].nameLen));
+        fullname = dirname;     // same join as DirScan::fullName
+        if (fullname.empty() || fullname.back() != Directory_files::SLASH_CHAR)
+            fullname += Directory_files::SLASH_CHAR;
+        fullname += name;
+        if (useSnapshot)
+            snapDir.subdirs.push_back(name);
+        fileCount += scanSubdir(ctx, directory, name, fullname, depth, showTotals);
+    }
+
+    if (showTotals)
+        addSnapExts(ctx, rec, useSnapshot ? &snapDir : nullptr);
+    if (useSnapshot && !Signals::aborted)
+        snapWriter.add(std::move(snapDir));
+    if (progress) {
+        Progress::add(ctx.progressFiles, ctx.progressBytes);
+        ctx.progressFiles = ctx.progressBytes = 0;
+    }
+    return fileCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -xdev, true if the current subdirectory entry is on the argument's device. The entry is
+// stat'ed relative to the open parent, so a mount point is never opened (or automounted).
+static
+bool onRootDevice(const DirScan& directory) {
+    FileStat subStat;
+    return !directory.stat(subStat, DirScan::NEED_TYPE) || subStat.dev == rootDev;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -xdev, remember the device of a root argument before scanning it.
+static
+void setRootDev(const std::string& filePath) {
+    struct stat filestat;
+    if (xdev && stat(filePath.c_str(), &filestat) == 0)
+        rootDev = filestat.st_dev;
+}
+
 //-------------------------------------------------------------------------------------------------
 // Recurse over directories, locate files.
+// Inside a parallel unit (ctx.pool set) subdirectories are queued as pool tasks instead of recursing.
 static
-size_t FindFiles(const lstring& dirname, unsigned depth) {
-    Directory_files directory(dirname);
+size_t FindDirFiles(ScanCtx& ctx, const lstring& dirname, unsigned depth, const DirScan* parent) {
+    ctx.dirsVisited++;
+    if (!fromSnapshotFile.empty()) {
+        const SnapDirRec* rec = snapReader.find(dirname);
+        if (rec == nullptr && dirname.length() > 1 && dirname.back() == Directory_files::SLASH_CHAR)
+            rec = snapReader.find(std::string_view(dirname).substr(0, dirname.length() - 1));
+        if (rec != nullptr)
+            return replayDir(ctx, *rec, dirname, depth, nullptr);
+        std::cerr << "Not in snapshot " << dirname << std::endl;
+        return 0;
+    }
+
+    // Open relative to parent's fd when recursing, saves the kernel a full path lookup.
+    DirScan directory = (parent != nullptr) ? DirScan(*parent, dirname) : DirScan(dirname);
     lstring fullname;
-    lstring timeStr;
     size_t fileCount = 0;
 
+    // -snapshot, stamp the directory before reading it so a change during the scan is seen next time.
+    FileStat dirStat;
+    bool recordDir = useSnapshot && directory.dirStat(dirStat);
+    if (recordDir) {
+        const SnapDirRec* rec = snapReader.find(dirname);
+        if (rec != nullptr && (rec->flags & SnapDirRec::FLAG_RACY) == 0
+                && rec->dev == dirStat.dev && rec->ino == dirStat.ino
+                && rec->mtime == (int64_t)dirStat.mtime && rec->ctime == (int64_t)dirStat.ctime)
+            return replayDir(ctx, *rec, dirname, depth, &directory);
+    }
+
+    if (useUring && needStat && sampleLimit == 0)
+        directory.prefetch(ctx.uringStat(), statNeed);
+
+    // Only a root argument can be a file, deeper calls come from directory entries.
     struct stat filestat;
     try {
-        if (stat(dirname, &filestat) == 0 && S_ISREG(filestat.st_mode)) {
-            fileCount += FindFile(dirname, depth);
+        if (depth == 0 && stat(dirname, &filestat) == 0 && S_ISREG(filestat.st_mode)) {
+            lstring name;
+            DirUtil::getName(name, dirname);
+            fullname = dirname;
+            fileCount += FindFile(ctx, nullptr, name, fullname, depth);
         }
     } catch (exception ex) {
         // Probably a pattern, let directory scan do its magic.
@@ -298,75 +840,226 @@ size_t FindFiles(const lstring& dirname, unsigned depth) {
 
     bool showTotals = summary && (depth == 0); //  && (dirname.find('*') != string::npos);
 
-    while (!Signals::aborted && directory.more()) {
-        time_t endT;
-        ParseUtil::fmtDateTime(timeStr, endT);
+    if (progress)
+        Progress::setDir(dirname);
+
+    SnapDir snapDir;
+    DuList ownList;
+    DuList* prevOwn = ctx.dirOwn;
+    size_t ownCount = 0;
+    ctx.dirOwn = recordDir ? &ownList : nullptr;
 
-        directory.fullName(fullname);
+    while (!Signals::aborted && directory.more()) {
+        fullname.clear();
         if (directory.is_directory()) {
-            lstring name;
-            DirUtil::getName(name, fullname);
-
-            if (isSideBySide)
-                fileNameList.insert(name);
-
-            if ((maxDepth == 0 || depth+1 < maxDepth)
-                    && (!dryrun || depth < 1)
-                    && !ParseUtil::FileMatches(fullname, excludeDirPatList, false)
-                //    && ParseUtil::FileMatches(fullname, includeDirPatList, true) 
-                    && !ParseUtil::FileMatches(name, excludeFilePatList, false)
-                //    && ParseUtil::FileMatches(name, includeFilePatList, true) 
-            ) {
-                if (verbose) {
-                    std::cout << "Dir:" << fullname << std::endl;
-                }
-                else if (std::difftime(endT, prevT) > 10) {
-                    if (progress) {
-                        clearProgress();
-                        progressLen = 6 + 7 + fullname.length();
-                        std::cerr << (size_t)std::difftime(endT, startT) << "(sec) " << fullname << "  \r";
-                    }
-                    prevT = endT;
-                }
+            if (xdev && !onRootDevice(directory))
+                continue;
+            lstring name = directory.name();
+            directory.fullName(fullname);
+            if (recordDir)
+                snapDir.subdirs.push_back(name);
+            fileCount += scanSubdir(ctx, &directory, name, fullname, depth, showTotals);
+        } else {
+            ownCount += FindFile(ctx, &directory, directory.nameView(), fullname, depth);
+        }
+    }
+    fileCount += ownCount;
+    ctx.dirOwn = prevOwn;
+
+    if (recordDir && !Signals::aborted) {
+        snapDir.path = dirname;
+        snapDir.dev = dirStat.dev;
+        snapDir.ino = dirStat.ino;
+        snapDir.mtime = dirStat.mtime;
+        snapDir.ctime = dirStat.ctime;
+        snapDir.fileCount = ownCount;
+        ownList.forEach([&snapDir](std::string_view ext, const DuSums& sums) {
+            snapDir.exts.emplace_back(std::string(ext), sums);
+        });
+        snapWriter.add(std::move(snapDir));
+    }
 
-                if (fullname.find_first_of('?') == string::npos) { 
-                    if (summary && ParseUtil::FileMatches(fullname, summaryDirPatList, false)) {
-                        clearUsage();
-                    }
-                    if (depth < MAX_DIR_DEPTH) {
-                        fileCount += FindFiles(fullname, depth + 1);
-                    }
-                    else {
-                        std::cerr << "Exceeded max directory depth " << MAX_DIR_DEPTH << std::endl;
-                        std::cerr << fullname << std::endl;
-                    }
-                }
-                else {
-                    // '?' not valid part of file name path. 
-                    std::cerr << "Invalid file name:" <<fullname << std::endl;
-                }
+    if (progress) {
+        Progress::add(ctx.progressFiles, ctx.progressBytes);
+        ctx.progressFiles = ctx.progressBytes = 0;
+    }
+    return fileCount;
+}
 
-                if (showTotals || ParseUtil::FileMatches(fullname, summaryDirPatList, false)) {
-                    if (! isSideBySide) {
-                        if (isTable) {
-                            buildTable(fullname);
-                        } else { /* if (!total) */
-                            printUsage(fullname);
-                        }
-                    } 
-#ifdef HAVE_WIN
-                    else if (depth == 0)
-                        printUsage(fullname);
-#endif
-                    clearUsage();
-                }
+//-------------------------------------------------------------------------------------------------
+// Scan one directory and total its own files, for -depth-report (added to dirTree below
+// ctx.dirNode) and -top directories (added to ctx.topDir's subtree total).
+static
+size_t FindFiles(ScanCtx& ctx, const lstring& dirname, unsigned depth, const DirScan* parent) {
+    if (depthReport == 0 && topCount == 0)
+        return FindDirFiles(ctx, dirname, depth, parent);
+
+    std::string_view name(dirname);
+    size_t slash = name.find_last_of(Directory_files::SLASH_CHAR, name.length() - 2);
+    if (depth != 0 && slash != std::string_view::npos)
+        name.remove_prefix(slash + 1);
+
+    DuSums ownSums;
+    uint32_t prevNode = ctx.dirNode;
+    DuSums* prevSums = ctx.dirSums;
+    TopDir* prevTop = ctx.topDir;
+    if (depthReport != 0)
+        ctx.dirNode = dirTree.add((depth == 0) ? DirTree::NO_NODE : prevNode, name, depth);
+    if (topCount != 0)
+        ctx.topDir = new TopDir(holdTopDir(prevTop), dirname);
+    ctx.dirSums = &ownSums;
+    size_t fileCount = FindDirFiles(ctx, dirname, depth, parent);
+    if (depthReport != 0)
+        dirTree.setOwn(ctx.dirNode, ownSums);
+    if (topCount != 0)
+        finishTopDir(ctx, ctx.topDir, topByDisk ? ownSums.diskSize : ownSums.fileSize);
+    ctx.dirNode = prevNode;
+    ctx.dirSums = prevSums;
+    ctx.topDir = prevTop;
+    return fileCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Scan directory tree, in parallel when the subtree cannot trigger a report (summary or
+// table row) part way through. Report points are left to the serial FindFiles so the
+// output matches a single threaded scan. Each worker aggregates into its own DuList
+// which are merged into ctx once the subtree is done.
+static
+size_t ScanTree(ScanCtx& ctx, const lstring& dirname, unsigned depth, const DirScan* parent) {
+    bool hasReports = !summaryDirPatList.empty() || (summary && depth == 0);
+    if (workPool == nullptr || hasReports)
+        return FindFiles(ctx, dirname, depth, parent);
+
+    uint32_t dirNode = ctx.dirNode;
+    TopDir* topDir = holdTopDir(ctx.topDir);
+    workPool->submit([dirname, depth, dirNode, topDir](unsigned worker) {
+        ScanCtx& wctx = *workerCtxs[worker];
+        wctx.dirNode = dirNode;
+        wctx.topDir = topDir;
+        wctx.fileCount += FindFiles(wctx, dirname, depth);
+        finishTopDir(wctx, topDir, 0);
+    });
+    workPool->wait();
+
+    size_t fileCount = 0;
+    for (auto& wctx : workerCtxs) {
+        ctx.duList.merge(wctx->duList);
+        wctx->duList.clear();
+        fileCount += wctx->fileCount;
+        wctx->fileCount = 0;
+    }
+    return fileCount;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -watch, initial scan of each argument then keep totals current until interrupted.
+static
+void runWatch() {
+    static ScanCtx watchCtx;
+    Watcher watcher(
+        [](const lstring& fullname, std::string_view name, std::string& ext, DuSums& sums) {
+            lstring path = fullname;
+            watchCtx.duList.clear();
+            if (FindFile(watchCtx, nullptr, name, path, 1) == 0)
+                return false;
+            watchCtx.duList.forEach([&ext, &sums](std::string_view fileExt, const DuSums& fileSums) {
+                ext = fileExt;
+                sums = fileSums;
+            });
+            return true;
+        },
+        [](const lstring& fullname, std::string_view name, unsigned depth) {
+            return (maxDepth == 0 || depth+1 < maxDepth)
+                && !excludeDirPatList.matches(fullname, false)
+                && !excludeFilePatList.matches(name, false)
+                && !skipSubtree(fullname);
+        });
+
+    for (auto const& filePath : fileDirList)
+        watcher.addRoot(filePath);
+    watcher.run(watchSec, printWatch);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Validate pattern option with ParseUtil, keep a compiled glob unless it needs std::regex.
+static
+bool addPattern(ParseUtil& parser, MatchList& matchList, lstring& value, const char* validCmd, const char* cmdName, bool reportErr = true) {
+    PatternList patList;
+    if (!parser.validPattern(patList, value, validCmd, cmdName, reportErr))
+        return false;
+    GlobPattern glob;
+    if (glob.compile(value, parser.unixRegEx, parser.ignoreCase))
+        matchList.globs.push_back(glob);
+    else if (!patList.empty())
+        matchList.regexes.push_back(patList.back());
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// True if pick pattern's result only depends on the name after its last dot.
+// Accepts <any>[.]<rest> where <any> is .* ..* or .+ (greedy, so [.] takes the last dot
+// it can) and <rest> is (.*) (.+) or a regex which can not match a '.'.
+// The key notes if the last dot is the first char, as ..* and .+ need one char before it.
+// toStr may only use groups, which are all inside <rest>.
+static
+bool suffixOnlyPick(const std::string& fromPat, const std::string& toStr) {
+    size_t pos;
+    if (fromPat.compare(0, 3, "..*") == 0)
+        pos = 3;
+    else if (fromPat.compare(0, 2, ".*") == 0 || fromPat.compare(0, 2, ".+") == 0)
+        pos = 2;
+    else
+        return false;
+    if (fromPat.compare(pos, 3, "[.]") == 0)
+        pos += 3;
+    else if (fromPat.compare(pos, 2, "\\.") == 0)
+        pos += 2;
+    else
+        return false;
+
+    std::string rest = fromPat.substr(pos);
+    unsigned minRest = 0;
+    if (rest == "(.+)" || rest == ".+") {
+        minRest = 1;
+    } else if (rest != "(.*)" && rest != ".*") {
+        bool inClass = false;
+        int depth = 0;
+        for (size_t idx = 0; idx < rest.length(); idx++) {
+            char chr = rest[idx];
+            if (chr == '\\') {
+                char esc = rest[++idx];
+                if (strchr("dwsbB", esc) == nullptr && (isalnum((unsigned char)esc) || esc == '.' || esc == '\0'))
+                    return false;   // \D \W \S \. back references ...
+            } else if (inClass) {
+                if (chr == '.' || chr == '-')
+                    return false;   // '.' or a range which may hold it
+                inClass = (chr != ']');
+            } else if (chr == '[') {
+                if (rest[idx + 1] == '^')
+                    return false;
+                inClass = true;
+            } else if (chr == '.' || (chr == '|' && depth == 0)) {
+                return false;       // any char, or alternative to the whole pattern
+            } else if (chr == '(') {
+                depth++;
+            } else if (chr == ')') {
+                depth--;
             }
-        } else if (fullname.length() > 0) {
-            fileCount += FindFile(fullname, depth);
         }
     }
 
-    return fileCount;
+    for (size_t idx = 0; idx < toStr.length(); idx++) {
+        if (toStr[idx] == '$') {
+            char next = (idx + 1 < toStr.length()) ? toStr[idx + 1] : '\0';
+            if (next == '$' || (next >= '1' && next <= '9'))
+                idx++;
+            else if (next == '&' || next == '`' || next == '\'' || next == '0')
+                return false;   // whole match, prefix or suffix
+        }
+    }
+
+    pickMinRest = std::max(pickMinRest, minRest);
+    return true;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -379,6 +1072,7 @@ void addPicker(const char* replaceArg) {
         pickPat.fromPat = std::regex(parts[0]);
         pickPat.toStr = parts[1];
         pickPatList.push_back(pickPat);
+        pickBySuffix = pickBySuffix && suffixOnlyPick(parts[0], parts[1]);
     }
 }
 
@@ -396,6 +1090,136 @@ void setSortBy(const char* value, bool forward) {
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+// Compile output formats after options are parsed.
+static
+void compileFormats() {
+    if (isTable && tableType[0] == 'a' && ageBy == 0)
+        ageBy = 'm';
+    if ((sizeHistogram || ageBy != 0 || groupBy != GROUP_EXT || estimateRate != 0) && setBothFmt == 0) {
+        static const char* const GROUP_HEAD[] = { "     Ext", "            User", "           Group", "        Ext:User" };
+        std::string fmt = (groupBy == GROUP_EXT) ? "%8.8e\t%8c\t%15s" : "%16.16e\t%8c\t%15s";
+        std::string head = std::string(GROUP_HEAD[groupBy]) + "\t   Count\t      Size";
+        if (ageBy != 0) {
+            fmt += "\t%15a30\t%15a90\t%15a365";
+            head += "\t       Size30d+\t       Size90d+\t      Size365d+";
+        }
+        if (estimateRate != 0) {
+            fmt += "\t%13m";
+            head += "\t        +-95%";
+        }
+        if (sizeHistogram) {
+            fmt += "\t%12p50\t%12p90\t%12p99\t%h";
+            head += "\t         p50\t         p90\t         p99\tBuckets";
+        }
+        tformat = formatDef = fmt + "\n";
+        if (header == DEF_HEADER)
+            header = head + "\n";
+    }
+    FormatPlan::initGrouping();
+    formatPlan.compile(formatDef.c_str());
+    formatPlan.setDiskSize(true);       // ext rows print disk size, totals print file size
+    totalPlan.compile(tformat.c_str());
+    summaryPlan.compile(sformat.c_str());
+    columnPlan.compile(cformat.c_str(), true);
+    topPlan.compile("%15s  %n\n");
+    devPlan.compile("%8c\t%15s  %n\n");
+    sizeHistogram = sizeHistogram || formatPlan.needsHist() || totalPlan.needsHist() || summaryPlan.needsHist();
+    if (ageBy == 0 && (formatPlan.needsAge() || totalPlan.needsAge() || summaryPlan.needsAge()))
+        ageBy = 'm';
+}
+
+//-------------------------------------------------------------------------------------------------
+// -estimate needs totals which scale with the file count, it is off with reports keyed or
+// filtered by per file stat data.
+static
+void setEstimate() {
+    if (estimateRate <= 0 || estimateRate >= 1) {
+        estimateRate = 0;
+        return;
+    }
+    if (groupBy != GROUP_EXT || byDevice || uniqueInodes || ageBy != 0 || (isTable && tableType[0] == 'a')
+            || topCount != 0 || depthReport != 0 || watchSec != 0 || !fromSnapshotFile.empty()) {
+        std::cerr << "-estimate ignored with -group, -by-device, -unique, -age, -top, -depth-report, -watch or -from-snapshot\n";
+        estimateRate = 0;
+        return;
+    }
+    if (!hasSeed)
+        sampleSeed = ((uint64_t)std::random_device{}() << 32) ^ (uint64_t)time(nullptr);
+    sampleLimit = (uint64_t)(estimateRate * 18446744073709551616.0);
+    std::cerr << "Estimate from " << estimateRate * 100 << "% sample of files, -seed=" << sampleSeed << std::endl;
+}
+
+//-------------------------------------------------------------------------------------------------
+// -from-snapshot only has per directory and ext totals, reports keyed or bucketed by per file
+// stat data are off.
+static
+void setFromSnapshot() {
+    if (fromSnapshotFile.empty())
+        return;
+    if (groupBy != GROUP_EXT || sizeHistogram || ageBy != 0 || topCount != 0 || byDevice) {
+        std::cerr << "-group, -histogram, -age, -top and -by-device ignored with -from-snapshot\n";
+        groupBy = GROUP_EXT;
+        sizeHistogram = false;
+        ageBy = 0;
+        topCount = 0;
+        byDevice = false;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// -watch keeps one DuSums per file, re-examined on each change. -unique is off as a file's
+// inode is already in inodeSet when it is seen again, and size buckets are not kept.
+static
+bool checkWatch() {
+    if (uniqueInodes) {
+        std::cerr << "-unique ignored with -watch\n";
+        uniqueInodes = false;
+    }
+    if (sizeHistogram || ageBy != 0) {
+        std::cerr << "-watch can not report -histogram, -age, -table=age or %p %h %a %o fields\n";
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Pruning only drops files the path filters reject, it is off when walking a directory
+// has other visible effects (verbose Dir: lines, -colum names, -summary reports).
+static
+void setCanPrune() {
+    canPrune = !verbose && !isSideBySide && !summary && summaryDirPatList.empty();
+}
+
+//-------------------------------------------------------------------------------------------------
+// A -snapshot only records per directory totals, it is off when the scan also produces per
+// file or order dependent output, or when totals depend on more than the directory itself.
+static
+void setUseSnapshot() {
+    useSnapshot = !snapshotFile.empty() && fromSnapshotFile.empty() && !verbose && !showFile && isSideBySide.empty() && !uniqueInodes
+        && !summary && !dryrun && summaryDirPatList.empty() && topCount == 0 && !sizeHistogram && ageBy == 0 && groupBy == GROUP_EXT && !byDevice && estimateRate == 0;
+    if (!snapshotFile.empty() && !useSnapshot)
+        std::cerr << "-snapshot ignored with -verbose, -column, -unique, -summary, -top, -histogram, -age, -group, -by-device, -estimate or -n\n";
+}
+
+//-------------------------------------------------------------------------------------------------
+// Decide if ExamineFile must stat each file or if dirent type is enough (count only reports).
+static
+void setNeedStat() {
+    if (uniqueInodes)
+        statNeed |= DirScan::NEED_INODE;
+    if (ageBy != 0)
+        statNeed |= DirScan::NEED_TIMES;    // same stat call, only asks statx for the times too
+    if (groupBy != GROUP_EXT)
+        statNeed |= DirScan::NEED_OWNER;
+    needStat = verbose || topCount != 0 || ageBy != 0 || groupBy != GROUP_EXT || byDevice
+        || (isTable && tableType[0] != 'c')
+        || (!summary && (formatPlan.needsStat() || totalPlan.needsStat()))
+        || (summary && summaryPlan.needsStat());
+    for (SortBy* sort = sortBy; sort != nullptr && !needStat; sort = sort->nextSort)
+        needStat = (sort->sortFunc == SortByDiskSize || sort->sortFunc == SortByFileSize);
+}
+
 //-------------------------------------------------------------------------------------------------
 void showHelp(const char* arg0) {
     const char* helpMsg =
@@ -411,10 +1235,12 @@ void showHelp(const char* arg0) {
             "   -_y_ExcludePath=<pathPattern>      ; Match against full dir path \n"
             "   NOTE - Patterns above - remember to escape backslash as \\\\ \n"
             "   -_y_verbose\n"
-            "   -_y_progress                       ; Show scan progress every 30 sec \n"
+            "   -_y_progress                       ; Show files, rate and dir every 10 sec \n"
             "   -_y_pick=<fromPat>;<toStr>         ; Def: ..*[.](.+);$1 \n"
             "   -_y_format=<format-3-values>       ; Def: %8.8e\\t%8c\\t%15s\\n \n"
             "        e=ext, c=count, l=links, s=size, n=name\n"
+            "        aNN=size, oNN=count of files NN or more days old (-age) \n"
+            "        m=95% margin of estimated size (-estimate), disk size on ext rows \n"
             "   -_y_format=<format-3-values>       ; Second format for Total \n"
             "   -_y_FormatSummary=<format-1-value> ; Summary Format, Def: \"%15s Files:%5c \\t%n\" \n"
             "   -_y_sort=ext|count|size            ; Def: ext \n"
@@ -423,8 +1249,28 @@ void showHelp(const char* arg0) {
             "   -_y_total                          ; Single report for all inputs \n"
             "   -_y_summary                        ; Single row for each path \n"
             "   -_y_summary=<dirPat>               ; Sumarize matching dirs \n"
-            "   -_y_table=count|size|links         ; Present results in table \n"
+            "   -_y_depth-report=N                 ; Summary row for each dir down to depth N \n"
+            "   -_y_top=N[,disk]                   ; List N largest files and dir trees, by size or disk size \n"
+            "   -_y_histogram                      ; Add file size p50, p90, p99 and log2 buckets \n"
+            "   -_y_age=mtime|atime                ; Add size of files 30, 90 and 365+ days old \n"
+            "   -_y_table=count|size|links|age     ; Present results in table \n"
+            "   -_y_group=uid|gid|ext+uid          ; Report by owner user, group or ext:user \n"
+            "   -_y_xdev                           ; Stay on the filesystem of each argument \n"
+            "   -_y_by-device                      ; Add totals per device (mount) \n"
+            "   -_y_estimate=<fraction>            ; Stat a sample of files, ex 0.02, extrapolate sizes \n"
+            "   -_y_seed=N                         ; Repeatable -estimate sample \n"
+            "   -_y_deadline=<seconds>             ; Stop descending when time is up, report coverage \n"
             "   -_y_divide                         ; Divide size by hardlink count \n"
+            "   -_y_unique                         ; Count size of hardlinked inode once \n"
+            "   -_y_unbuffered                     ; Write output as it is produced \n"
+            "   -_y_threads=N                      ; Parallel scan with N threads, 0=all cores \n"
+            "   -_y_engine=sync|uring              ; Linux, uring=batch stat per directory with io_uring \n"
+            "   -_y_snapshot=<file>                ; Reuse totals of dirs unchanged since last scan \n"
+            "        Note - file content edits which do not change the dir are not seen \n"
+            "   -_y_from-snapshot=<file>           ; Report from snapshot without scanning \n"
+            "        Note - -summary rows can differ from a scan, root files go to the root total \n"
+            "   -_y_diff=<oldSnap> <newSnap>       ; Growth by dir and ext between snapshots \n"
+            "   -_y_watch[=<seconds>]              ; Keep totals current, report every 10 sec \n"
             "\n"
             "   -_y_column=access|create|modify|size|link ; Side-by-size 2 or more dirs\n"
             "   -_y_CFMT=%15.15s\\t               ; 1st col format name\n"
@@ -464,6 +1310,11 @@ void showHelp(const char* arg0) {
             "   lldu  -_y_rev=size -_y_rev=count -_y_format='%8e %6c %20s\\n' -_y_for='\\n' -_y_head=' ' . \n"
             "   lldu  -_y_format=\"%9.9e\\t%8c\\t%15s\\n\" -_y_format=\"%9.9e\\t%8c\\t%15s\\n\"  . \n"
             "   lldu  -_y_FormatSummary=\"%8.8n\\t%8c\\t%15s\\n\"  . \n"
+            "   find . -type d -name logs | lldu -_y_progress - \n"
+            "   lldu  -_y_depth-report=3 -_y_sort=size /var \n"
+            "   lldu  -_y_snapshot=$HOME/.lldu-home.snap ~/ \n"
+            "   lldu  -_y_from-snapshot=$HOME/.lldu-home.snap -_y_sum -_y_sort=size \n"
+            "   lldu  -_y_diff=yesterday.snap today.snap \n"
             "   lldu  -_y_ver -_y_Include='*/[.][a-zA-Z]*' ~/ \n"
             "\n Show hardlinks (%l or %L format) \n"
             "   lldu  -_y_header=\"   Exten\\tFileSize\\tLinks\\n\" -_y_format=\"%8.8e\\t%8s\\t%5L\\n\"  . \n"
@@ -473,6 +1324,7 @@ void showHelp(const char* arg0) {
             " _p_Format:\n"
             "    uses standard printf formatting except for these special cases\n"
             "    e=file extension, c=count, s=size, l=links, n=name (with summary)\n"
+            "    pNN=file size at percentile NN (ex %12p90), h=log2 size buckets \n"
             "    lowercase c,s,l  format with commas \n"
             "    uppercase  C,S,L  format without commas \n"
             "    precede with width, ex %12.12e\\t%8c\\t%15s\\n \n"
@@ -511,7 +1363,12 @@ int main(int argc, char* argv[]) {
         bool doParseCmds = true;
         string endCmds = "--";
         for (int argn = 1; argn < argc; argn++) {
-            if (*argv[argn] == '-' && doParseCmds) {
+            if (doParseCmds && endCmds == argv[argn]) {
+                doParseCmds = false;    // rest are paths
+                continue;
+            }
+            // A lone '-' reads paths from stdin.
+            if (*argv[argn] == '-' && argv[argn][1] != '\0' && doParseCmds) {
                 lstring argStr(argv[argn]);
                 Split cmdValue(argStr, "=", 2);
                 if (cmdValue.size() == 2) {
@@ -522,6 +1379,11 @@ int main(int argc, char* argv[]) {
                     if (cmd.length() > 2 && *cmdName == '-')
                         cmdName++;  // allow -- prefix on commands
                     switch (*cmdName) {
+                        case 'a':   // age=mtime|atime
+                            if (parser.validOption("age", cmdName)) {
+                                ageBy = (value[0] == 'a') ? 'a' : 'm';
+                            }
+                            break;
                         case 'c':   // column=count|size|hardlinks|file
                             if (parser.validOption("colum", cmdName)) {
                                 isSideBySide = value;
@@ -534,15 +1396,30 @@ int main(int argc, char* argv[]) {
                             }
                             break;
                         case 'd': // depth=0..n
-                            if (parser.validOption("depth", cmdName))  {
+                            if (parser.validOption("depth", cmdName, false))  {
                                 maxDepth = atoi(value);
+                            } else if (parser.validOption("depth-report", cmdName, false))  {
+                                depthReport = std::max(0, atoi(value)) + 1;
+                            } else if (parser.validOption("deadline", cmdName, false))  {
+                                deadlineSec = std::max(0, atoi(value));
+                            } else if (parser.validOption("diff", cmdName)) {
+                                diffSnapshotFile = value;
                             }
                             break;
                         case 'e':   // excludeItem=<patFile>
-                            parser.validPattern(excludeFilePatList, value, "excludeItem", cmdName);
+                            if (addPattern(parser, excludeFilePatList, value, "excludeItem", cmdName, false)) {
+                                snapOptions += argStr + "\n";
+                            } else if (parser.validOption("engine", cmdName, false)) {     // engine=sync|uring
+                                useUring = !value.empty() && strncasecmp("uring", value, value.length()) == 0;
+                            } else if (parser.validOption("estimate", cmdName)) {   // estimate=<fraction>
+                                estimateRate = atof(value);
+                                if (value.back() == '%')
+                                    estimateRate /= 100;
+                            }
                             break;
                         case 'E':   // ExcludePath=<patFile>
-                            parser.validPattern(excludeDirPatList, value, "ExcludePath", cmdName);
+                            addPattern(parser, excludeDirPatList, value, "ExcludePath", cmdName);
+                            snapOptions += argStr + "\n";
                             break;
                         case 'f':   // format=<str>
                             if (parser.validOption("format", cmdName, false)) {
@@ -550,6 +1427,8 @@ int main(int argc, char* argv[]) {
                                     tformat = formatDef = ParseUtil::convertSpecialChar(value);
                                 else
                                     tformat = ParseUtil::convertSpecialChar(value);
+                            } else if (parser.validOption("from-snapshot", cmdName, false)) {
+                                fromSnapshotFile = value;
                             } else if (parser.validOption("formatSummary", cmdName)) {
                                 sformat = ParseUtil::convertSpecialChar(value);
                             }
@@ -559,20 +1438,32 @@ int main(int argc, char* argv[]) {
                                 sformat = ParseUtil::convertSpecialChar(value);
                             }
                             break;
+                        case 'g':   // group=uid|gid|ext+uid
+                            if (parser.validOption("group", cmdName)) {
+                                switch (tolower(value[0])) {
+                                case 'g': groupBy = GROUP_GID; break;
+                                case 'e': groupBy = GROUP_EXT_UID; break;
+                                default:  groupBy = GROUP_UID; break;
+                                }
+                            }
+                            break;
                         case 'h':   // header=<str>
                             if (parser.validOption("header", cmdName)) {
                                 header = ParseUtil::convertSpecialChar(value);
                             }
                             break;
                         case 'i':   // includeItem=<patFile>
-                            parser.validPattern(includeFilePatList, value, "includeItem", cmdName);
+                            addPattern(parser, includeFilePatList, value, "includeItem", cmdName);
+                            snapOptions += argStr + "\n";
                             break;
                         case 'I':   // IncludePath=<patFile>
-                            parser.validPattern(includeDirPatList, value, "IncludePath", cmdName);
+                            addPattern(parser, includeDirPatList, value, "IncludePath", cmdName);
+                            snapOptions += argStr + "\n";
                             break;
                         case 'p': // pick=<fromPat>;<toText>
                             if (parser.validOption("pick", cmdName)) {
                                 addPicker(ParseUtil::convertSpecialChar(value));
+                                snapOptions += argStr + "\n";
                             }
                             break;
                         case 'r':
@@ -585,7 +1476,9 @@ int main(int argc, char* argv[]) {
                                 separator = ParseUtil::convertSpecialChar(value);
                             } else if (parser.validOption("sort", cmdName, false)) {
                                 setSortBy(value, true);
-                            } else if (parser.validPattern(summaryDirPatList, value, "summary", cmdName, false)) {
+                            } else if (parser.validOption("snapshot", cmdName, false)) {
+                                snapshotFile = value;
+                            } else if (addPattern(parser, summaryDirPatList, value, "summary", cmdName, false)) {
                                 summary = true;
 #ifdef HAVE_WIN
                                 lstring incDirPat = value + Directory_files::SLASH2 + ".*";
@@ -593,13 +1486,28 @@ int main(int argc, char* argv[]) {
                                 lstring incDirPat = value + Directory_files::SLASH + ".*";
 #endif
                                 std::regex pat = parser.ignoreCase ? std::regex(incDirPat, regex_constants::icase) : std::regex(incDirPat);
-                                includeDirPatList.push_back(pat);
-                            } 
+                                includeDirPatList.regexes.push_back(pat);
+                            } else if (parser.validOption("seed", cmdName)) {
+                                sampleSeed = strtoull(value, nullptr, 10);
+                                hasSeed = true;
+                            }
                             break;
                         case 't':   // table=count|size|hardlinks|file
-                            if (parser.validOption("table", cmdName)) {
+                            if (parser.validOption("table", cmdName, false)) {
                                 tableType = value;
                                 isTable = true;
+                            } else if (parser.validOption("top", cmdName, false)) {
+                                topCount = std::max(0, atoi(value));
+                                topByDisk = strstr(value, ",disk") != nullptr;
+                            } else if (parser.validOption("threads", cmdName)) {
+                                threadCnt = atoi(value);
+                                if (threadCnt == 0)
+                                    threadCnt = std::max(1u, std::thread::hardware_concurrency());
+                            }
+                            break;
+                        case 'w':   // watch=<seconds>
+                            if (parser.validOption("watch", cmdName)) {
+                                watchSec = std::max(1, atoi(value));
                             }
                             break;
                         default:
@@ -614,14 +1522,19 @@ int main(int argc, char* argv[]) {
                     case 'a':
                         showAbsPath = parser.validOption("absolute", cmdName);
                         break;
+                    case 'b':   // -by-device
+                        byDevice = parser.validOption("by-device", cmdName);
+                        break;
                     case 'd':
                         divByHardlink = parser.validOption("divide", cmdName);
+                        snapOptions += argStr + "\n";
                         break;
                     case 'h':
-                        if (parser.validOption("help", cmdName)) {
+                        if (parser.validOption("help", cmdName, false)) {
                             showHelp(argv[0]);
                             return 0;
                         }
+                        sizeHistogram = parser.validOption("histogram", cmdName);
                         break;
                     case 'l':   // -list
                         listDev = parser.validOption("list", cmdName);
@@ -634,6 +1547,13 @@ int main(int argc, char* argv[]) {
                         break;
                     case 'r':   // -regex
                         parser.unixRegEx = parser.validOption("regex", cmdName);
+                        snapOptions += argStr + "\n";
+                        break;
+                    case 'u':   // -unique or -unbuffered
+                        if (parser.validOption("unique", cmdName, false))
+                            uniqueInodes = true;
+                        else if (parser.validOption("unbuffered", cmdName))
+                            OutSink::setUnbuffered(true);
                         break;
                     case 's':   // -summary
                         summary = parser.validOption("summary", cmdName);
@@ -644,16 +1564,20 @@ int main(int argc, char* argv[]) {
                     case 'v':   // -v=true or -v=anyThing
                         verbose = parser.validOption("verbose", cmdName);
                         break;
+                    case 'w':   // -watch
+                        if (parser.validOption("watch", cmdName))
+                            watchSec = WATCH_SEC;
+                        break;
+                    case 'x':   // -xdev
+                        xdev = parser.validOption("xdev", cmdName);
+                        snapOptions += argStr + "\n";
+                        break;
                     case '?':
                         showHelp(argv[0]);
                         return 0;
                     default:
                         parser.showUnknown(argStr);
                     }
-
-                    if (endCmds == argv[argn]) {
-                        doParseCmds = false;
-                    }
                 }
             } else {
                 // Store file directories
@@ -664,26 +1588,101 @@ int main(int argc, char* argv[]) {
         if (pickPatList.empty()) {
             addPicker("..*[.](.+);$1");
         }
+        setEstimate();
+        setFromSnapshot();
+        compileFormats();
+        setNeedStat();
+        setCanPrune();
+        setUseSnapshot();
+        if (useUring && !UringStat::available()) {
+            std::cerr << "io_uring not available, using -engine=sync\n";
+            useUring = false;
+        }
 
        
         if (parser.patternErrCnt == 0 && parser.optionErrCnt == 0) {
             if (listDev) {
                 Storage::ListStorageSizes();
-            } else if (fileDirList.size() != 0) {
+            } else if (!diffSnapshotFile.empty()) {
+                if (fileDirList.size() != 1) {
+                    std::cerr << "-diff=<oldSnapshot> needs one <newSnapshot> argument\n";
+                    return -1;
+                }
+                if (!SnapshotDiff::report(diffSnapshotFile, fileDirList[0].c_str(), DIFF_ROWS))
+                    return -1;
+            } else if (!fromSnapshotFile.empty() && (sizeHistogram || ageBy != 0)) {
+                std::cerr << "-from-snapshot can not report -table=age or %p %h %a %o fields\n";
+                return -1;
+            } else if (!fromSnapshotFile.empty() && !snapReader.open(fromSnapshotFile, 0)) {
+                std::cerr << "Unable to read snapshot " << fromSnapshotFile << std::endl;
+                return -1;
+            } else if (watchSec != 0 && fileDirList.size() != 0) {
+                if (!checkWatch())
+                    return -1;
+                runWatch();
+            } else if (fileDirList.size() != 0 || snapReader.isOpen()) {
+                if (fileDirList.empty()) {
+                    // -from-snapshot without paths reports the snapshot's own arguments.
+                    std::vector<std::string_view> roots;
+                    snapReader.roots(roots);
+                    for (std::string_view root : roots)
+                        fileDirList.push_back(std::string(root));
+                }
+                if (!fromSnapshotFile.empty() && !snapOptions.empty())
+                    std::cerr << "-from-snapshot totals use the file patterns and -pick of the snapshot scan\n";
+                if (!fromSnapshotFile.empty() && summary)
+                    std::cerr << "-from-snapshot -summary rows count each root's own files in the root total\n";
+
                 ParseUtil::fmtDateTime(timeStr, startT);
-                prevT = startT;
+                deadlineAt = std::chrono::steady_clock::now() + std::chrono::seconds(deadlineSec);
                 if (! summary)
                     std::cerr << Colors::colorize("_G_ +Start ") << timeStr << Colors::colorize("_X_\n");
 
+                if (threadCnt > 1) {
+                    workPool = new WorkPool(threadCnt);
+                    for (unsigned worker = 0; worker < threadCnt; worker++) {
+                        workerCtxs.push_back(std::unique_ptr<ScanCtx>(new ScanCtx()));
+                        workerCtxs.back()->worker = worker;
+                        workerCtxs.back()->pool = workPool;
+                        workerCtxs.back()->topFiles.setLimit(topCount);
+                        workerCtxs.back()->topDirs.setLimit(topCount);
+                    }
+                }
+
+                uint64_t snapKey = 0;
+                if (useSnapshot) {
+                    snapOptions += needStat ? "stat " : "nostat ";
+                    snapOptions += std::to_string(statNeed);
+                    snapKey = snapshotKey(snapOptions);
+                    snapReader.open(snapshotFile, snapKey);     // missing or stale file is a full scan
+                }
+
+                if (progress && !verbose)
+                    Progress::start(PROGRESS_SEC);
+
+                mainCtx.topFiles.setLimit(topCount);
+                mainCtx.topDirs.setLimit(topCount);
                 if (fileDirList.size() == 1 && fileDirList[0] == "-") {
                     string filePath;
                     while (std::getline(std::cin, filePath)) {
-                        FindFiles(filePath, 0);
+                        if (pastDeadline()) {
+                            deadlineSkip(filePath);
+                            continue;
+                        }
+                        setRootDev(filePath);
+                        ScanTree(mainCtx, filePath, 0);
                     }
                 } else {
                     for (auto const& filePath : fileDirList) {
-                        FindFiles(filePath, 0);
-                        if (isSideBySide.empty()) {
+                        if (pastDeadline()) {
+                            deadlineSkip(filePath);
+                            continue;
+                        }
+                        setRootDev(filePath);
+                        ScanTree(mainCtx, filePath, 0);
+                        if (depthReport != 0) {
+                            // reported once the whole tree is known
+                        } else if (isSideBySide.empty()) {
                             if (isTable) {
                                 buildTable(filePath);
                             } else { /* if (!total) */
@@ -695,22 +1694,30 @@ int main(int argc, char* argv[]) {
                     
                 }
 
+                if (progress)
+                    Progress::stop();
+
+                if (useSnapshot && !Signals::aborted) {
+                    snapReader.close();
+                    if (!snapWriter.write(snapshotFile, snapKey, startT))
+                        std::cerr << "Failed to write snapshot " << snapshotFile << std::endl;
+                }
+
                 if ( ! isSideBySide.empty()) {
                     struct stat filestat;
                     // std::sort(fileNameList.begin(), fileNameList.end());
-                    const char* cfmt = cformat.c_str();
-                    printf(cfmt, "Name");
+                    printParts(columnPlan, "Name", 0, 0, 0);
                     for (auto const& filePath : fileDirList) {
                         int len = filePath.length();
-                        printf("%15.15s\t", filePath.c_str() + std::max(0, len-15));
+                        OutSink::print("%15.15s\t", filePath.c_str() + std::max(0, len-15));
                     }
-                    printf("\n");
+                    OutSink::put('\n');
                     for (auto const& name : fileNameList) {
 
                         if (Signals::aborted)
                             break;
 
-                        printf(cfmt, name.c_str());
+                        printParts(columnPlan, name.c_str(), 0, 0, 0);
                         for (auto const& filePath : fileDirList) {
                             string fullname = filePath + Directory_files::SLASH + name;
                             // Use lstat to avoid following the link to its target
@@ -735,19 +1742,31 @@ int main(int argc, char* argv[]) {
                                     printTime(tvalue, "%d-%b-%y %H:%M\t");
                                     break;
                                 default:
-                                    printf("%15lu ", (unsigned long)value);
+                                    OutSink::print("%15lu ", (unsigned long)value);
                                 }
                             } else {
-                                printf("%15.15s\t", "--");
+                                OutSink::print("%15.15s\t", "--");
                             }
                         }
-                        printf("\n");
+                        OutSink::put('\n');
                     }
-                } if (isTable) {
+                    OutSink::flush();
+                } if (depthReport != 0) {
+                    printDepthReport();
+                } else if (isTable) {
                     printTable();
                 } else {
                     printUsage(""); // print grand total
                 }
+                if (topCount != 0)
+                    printTop();
+                if (byDevice)
+                    printDevices();
+                if (deadlineHit)
+                    printCoverage();
+
+                delete workPool;
+                workPool = nullptr;
 
                 if (! summary) {
                     time_t endT;
@@ -774,8 +1793,8 @@ void printTime(time_t epoch, const char* tmFmt) {
     struct tm* localTm;
     localTm = localtime(&epoch);
     char timbuf[80];
-    strftime(timbuf, sizeof(timbuf), tmFmt, localTm);
-    printf(timbuf);
+    size_t len = strftime(timbuf, sizeof(timbuf), tmFmt, localTm);
+    OutSink::write(timbuf, len);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -784,168 +1803,19 @@ void clearUsage() {
     duList.clear();
 }
 
-// ---------------------------------------------------------------------------
-#include <locale>
-#include <iostream>
-
-template <typename Ch>
-class numfmt: public std::numpunct<Ch> {
-    int group;    // Number of characters in a group
-    Ch  separator; // Character to separate groups
-public:
-    numfmt(Ch sep, int grp): separator(sep), group(grp) {}
-private:
-    Ch do_thousands_sep() const { return separator; }
-    std::string do_grouping() const { return std::string(1, group); }
-};
-
-inline void EnableCommaCout() {
-#if 0
-    char sep = ',';
-    int group = 3;
-    std::cout.imbue(std::locale(std::locale(),
-        new numfmt<char>(sep, group)));
-#else
-    setlocale(LC_ALL, "");
-    std::locale mylocale("");   // Get system locale
-    std::cout.imbue(mylocale);
-#endif
-}
-
-inline void DisableCommaCout() {
-    std::cout.imbue(std::locale(std::locale()));
-}
-
-
-#if 0
-// ---------------------------------------------------------------------------
-const char* fmtNumComma(size_t n, char*& buf) {
-    char* result = buf;
-    /*
-     // if n is signed value.
-    if (n < 0) {
-        *buf++ = "-";
-        return printfcomma(-n, buf);
-    }
-    */
-    if (n < 1000) {
-        buf += snprintf((char*)buf, 4, "%lu", (unsigned long)n);
-        return result;
-    }
-    fmtNumComma(n / 1000, buf);
-    buf += snprintf((char*)buf, 5, ",%03lu", (unsigned long) n % 1000);
-    return result;
-}
-
-// Legacy ?windows? way of adding commas
-char buf[40];
-printf("%s", fmtNumComma(value, buf));
-#endif
-
-#if defined(__APPLE__) && defined(__MACH__)
-    #include <printf.h>
-    #define PRINTF(a,b) xprintf(_domain, NULL, a,b)
-    static printf_domain_t _domain;
-#else
-    #define PRINTF(a,b) printf(a,b)
-#endif
-
-inline void initPrintf() {
-#if defined(__APPLE__) && defined(__MACH__)
-    _domain = new_printf_domain();
-    setlocale(LC_ALL, "en_US.UTF-8");
-#endif
-}
-
 //-------------------------------------------------------------------------------------------------
+// Render row with a compiled format into a reused buffer, written to OutSink with one call.
 void printParts(
-    const char* customFmt,
+    const FormatPlan& plan,
     const char* name,
     size_t count,
     size_t links,
-    size_t size) {
-    /*
-    #if defined(__APPLE__) && defined(__MACH__)
-        printf_domain_t domain = new_printf_domain();
-        setlocale(LC_ALL, "en_US.UTF-8");
-    #endif
-     */
-    initPrintf();
-
-    // Handle custom printf syntax to get to path parts:
-    //    %#.#s
-    //   n=name c=count, s=size
-
-    const int NONE = 12345;
-    lstring itemFmt;
-#ifdef HAVE_WIN
-    const char* FMT_NUMB = "zu";
-    const char* FMT_COMMA = "zu";
-#else
-    const char* FMT_COMMA = "'lu";  //  "`lu" linux supports ` to add commas
-    const char* FMT_NUMB = "lu";     
-#endif
- 
-    char* fmt = (char*)customFmt;
-    while (*fmt) {
-        char c = *fmt;
-        if (c != '%') {
-            putchar(c);
-            fmt++;
-        } else {
-            const char* begFmt = fmt;
-            int precision = NONE;
-            int width = (int)strtol(fmt + 1, &fmt, 10);
-            if (*fmt == '.') {
-                precision = (int)strtol(fmt + 1, &fmt, 10);
-            }
-            c = *fmt;
-
-            itemFmt = begFmt;
-            itemFmt.resize(fmt - begFmt);
-            EnableCommaCout();
-
-            switch (c) {
-            case 'e':   // Extension
-            case 'n':   // name
-                itemFmt += "s";
-                printf(itemFmt, name);
-                break;
-            case 'C':   // Count
-                // DisableCommaCout();
-                itemFmt += FMT_NUMB;        // unsigned long formatter
-                printf(itemFmt, count);     // print with commas
-                break;
-            case 'c':   // Count
-                itemFmt += FMT_COMMA;       // unsigned long formatter
-                PRINTF(itemFmt, count);     // print with commas
-                break;
-            case 'L':   // Links
-                // DisableCommaCout();
-                itemFmt += FMT_NUMB;        // unsigned long formatter
-                printf(itemFmt, links);
-                break;
-            case 'l':   // Links
-                itemFmt += FMT_COMMA;       // unsigned long formatter
-                PRINTF(itemFmt, links);
-                break;
-            case 'S':   // Size
-                // DisableCommaCout();
-                itemFmt += FMT_NUMB;        // unsigned long formatter
-                printf(itemFmt, size);
-                break;
-            case 's':   // Size
-                itemFmt += FMT_COMMA;       // unsigned long formatter
-                PRINTF(itemFmt, size);
-                break;
-
-            default:
-                putchar(c);
-                break;
-            }
-            fmt++;
-        }
-    }
+    size_t size,
+    const DuInfo* detail) {
+    static std::string rowBuf;
+    rowBuf.clear();
+    plan.render(rowBuf, name, count, links, size, detail);
+    OutSink::write(rowBuf);
 }
 
 
@@ -954,6 +1824,7 @@ size_t gtotalCount = 0;
 size_t gtotalLinks = 0;
 size_t gtotalDiskSize = 0;
 size_t gtotalFileSize = 0;
+DuInfo gtotalDetail;     // -histogram and -age buckets
 std::vector<DuInfo> summaryInfos;
 
 void printUsage(const std::string& filepath) {
@@ -961,27 +1832,32 @@ void printUsage(const std::string& filepath) {
     size_t totalLinks = 0;
     size_t totalDiskSize = 0;
     size_t totalFileSize = 0;
+    DuInfo totalDetail;
 
     if (! summary) {
-        printf("\n%s\n", filepath.c_str());
+        OutSink::print("\n%s\n", filepath.c_str());
         if (! total)
-            printf(header.c_str());
+            OutSink::write(header);
     }
 
     typedef std::vector<DuInfo> VecDuList;
     VecDuList::const_iterator iter;
     VecDuList vecDuList;
-    for (const auto &info : duList)
-        vecDuList.push_back(info.second);
+    duList.getInfos(vecDuList);
+    if (estimateRate != 0)
+        DuInfo::extrapolate(vecDuList);
 
     if (sortBy == nullptr)
         sortBy = defSortBy;
     
-    std::sort(vecDuList.begin(), vecDuList.end(), *sortBy);
+    // DuList is unordered, start from ext order so ties sort as they always have.
+    std::sort(vecDuList.begin(), vecDuList.end(), *defSortBy);
+    if (sortBy != defSortBy)
+        std::sort(vecDuList.begin(), vecDuList.end(), *sortBy);
     for (auto iter = vecDuList.cbegin(); iter != vecDuList.cend(); iter++) {
         if (! summary && ! total) {
             if (formatDef.length() > 0) {
-                printParts(formatDef.c_str(), iter->ext.c_str(), iter->count, iter->hardlinks, iter->diskSize);
+                printParts(formatPlan, iter->ext.c_str(), iter->count, iter->hardlinks, iter->diskSize, &*iter);
             } else {
                 // std::cout << iter->first << separator << iter->second.count << separator << iter->second.diskSize << std::endl;
             }
@@ -990,12 +1866,20 @@ void printUsage(const std::string& filepath) {
         totalLinks += iter->hardlinks;
         totalDiskSize += iter->diskSize;
         totalFileSize += iter->fileSize;
+        if (sizeHistogram)
+            totalDetail.hist += iter->hist;
+        if (ageBy != 0)
+            totalDetail.age += iter->age;
+        totalDetail.est += iter->est;
     }
 
     gtotalCount += totalCount;
     gtotalLinks += totalLinks;
     gtotalDiskSize += totalDiskSize;
     gtotalFileSize += totalFileSize;
+    gtotalDetail.hist += totalDetail.hist;
+    gtotalDetail.age += totalDetail.age;
+    gtotalDetail.est += totalDetail.est;
 
     if (summary) {
         if (filepath.empty()) {
@@ -1006,11 +1890,11 @@ void printUsage(const std::string& filepath) {
                     unsigned off = 0;
                     if (!showAbsPath && sumPath.length() > CWD_LEN+1 && strncmp(sumPath.c_str(), CWD_BUF, CWD_LEN) == 0)
                         off = CWD_LEN;
-                    printParts(sformat.c_str(), sumPath.c_str() + off, iter->count, iter->hardlinks, iter->fileSize);
+                    printParts(summaryPlan, sumPath.c_str() + off, iter->count, iter->hardlinks, iter->fileSize, &*iter);
                 }
                 summaryInfos.clear();
             }
-            printParts(sformat.c_str(), "_GTotal", gtotalCount, gtotalLinks, gtotalFileSize);
+            printParts(summaryPlan, "_GTotal", gtotalCount, gtotalLinks, gtotalFileSize, &gtotalDetail);
         } else {
             unsigned off = 0;
             if (!showAbsPath && filepath.length() > CWD_LEN+1 && strncmp(filepath.c_str(), CWD_BUF, CWD_LEN) == 0) 
@@ -1018,25 +1902,148 @@ void printUsage(const std::string& filepath) {
             
             clearProgress();
             if (sortBy == nullptr) {
-                printParts(sformat.c_str(), filepath.c_str() + off, totalCount, totalLinks, totalFileSize);
+                printParts(summaryPlan, filepath.c_str() + off, totalCount, totalLinks, totalFileSize, &totalDetail);
             } else {
                 summaryInfos.push_back(DuInfo(filepath, totalCount, totalDiskSize, totalFileSize, totalLinks));
+                summaryInfos.back().hist = totalDetail.hist;
+                summaryInfos.back().age = totalDetail.age;
+                summaryInfos.back().est = totalDetail.est;
             }
         }
     } else {
         if (tformat.length() > 0) {
             if (filepath.empty())
-                printParts(tformat.c_str(), "_GTotal", gtotalCount, gtotalLinks, gtotalFileSize);
+                printParts(totalPlan, "_GTotal", gtotalCount, gtotalLinks, gtotalFileSize, &gtotalDetail);
             else
-                printParts(tformat.c_str(), "_Total", totalCount, totalLinks, totalFileSize);
+                printParts(totalPlan, "_Total", totalCount, totalLinks, totalFileSize, &totalDetail);
         } else {
             // std::cout << iter->first << separator << iter->second.count << separator << iter->second.diskSize << std::endl;
         }
     }
+
+    // Report boundary, summary rows are only flushed with the grand total.
+    if (!summary || filepath.empty())
+        OutSink::flush();
 }
 
 
 
+//-------------------------------------------------------------------------------------------------
+// -depth-report, subtree totals of every directory down to the requested depth, one row
+// per directory using the summary format.
+void printDepthReport() {
+    dirTree.rollUp();
+
+    std::vector<DuInfo> rows;
+    size_t totalCount = 0;
+    size_t totalLinks = 0;
+    size_t totalFileSize = 0;
+    for (uint32_t idx = 0; idx < dirTree.size(); idx++) {
+        const DirTree::Node& node = dirTree.node(idx);
+        if (node.depth < depthReport)
+            rows.push_back(DuInfo(dirTree.path(idx, Directory_files::SLASH_CHAR),
+                node.count, node.diskSize, node.fileSize, node.hardlinks));
+        if (node.parent == DirTree::NO_NODE) {
+            totalCount += node.count;
+            totalLinks += node.hardlinks;
+            totalFileSize += node.fileSize;
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(), *defSortBy);
+    if (sortBy != nullptr && sortBy != defSortBy)
+        std::sort(rows.begin(), rows.end(), *sortBy);
+    clearProgress();
+    for (const DuInfo& row : rows) {
+        unsigned off = 0;
+        if (!showAbsPath && row.ext.length() > CWD_LEN+1 && strncmp(row.ext.c_str(), CWD_BUF, CWD_LEN) == 0)
+            off = CWD_LEN;
+        printParts(summaryPlan, row.ext.c_str() + off, row.count, row.hardlinks, row.fileSize);
+    }
+    printParts(summaryPlan, "_GTotal", totalCount, totalLinks, totalFileSize);
+    OutSink::flush();
+}
+
+//-------------------------------------------------------------------------------------------------
+// -top, merge each thread's lists and print largest first.
+void printTop() {
+    for (auto& wctx : workerCtxs) {
+        mainCtx.topFiles.merge(wctx->topFiles);
+        mainCtx.topDirs.merge(wctx->topDirs);
+    }
+
+    std::vector<TopList::Entry> entries;
+    const char* sizeName = topByDisk ? "disk size" : "size";
+    clearProgress();
+    OutSink::print("\nLargest files by %s\n", sizeName);
+    mainCtx.topFiles.getSorted(entries);
+    for (const TopList::Entry& entry : entries)
+        printParts(topPlan, entry.name.c_str(), 0, 0, entry.value);
+    OutSink::print("\nLargest directories by %s, including subdirectories\n", sizeName);
+    mainCtx.topDirs.getSorted(entries);
+    for (const TopList::Entry& entry : entries)
+        printParts(topPlan, entry.name.c_str(), 0, 0, entry.value);
+    OutSink::flush();
+}
+
+//-------------------------------------------------------------------------------------------------
+// -by-device, merge each thread's device totals and print them in device order.
+void printDevices() {
+    for (auto& wctx : workerCtxs) {
+        for (const auto& item : wctx->devSums)
+            mainCtx.devSums[item.first] += item.second;
+    }
+
+    std::map<unsigned long long, DuSums> devices(mainCtx.devSums.begin(), mainCtx.devSums.end());
+    clearProgress();
+    OutSink::print("\nTotals by device\n");
+    for (const auto& item : devices) {
+        std::string label = Storage::DeviceLabel(item.first);
+        printParts(devPlan, label.c_str(), item.second.count, item.second.hardlinks, item.second.fileSize);
+    }
+    OutSink::flush();
+}
+
+//-------------------------------------------------------------------------------------------------
+// -deadline reached, the reports above only cover the directories visited. Skipped subtrees
+// were never opened, so the fraction is of directories reached, an upper bound on coverage.
+void printCoverage() {
+    size_t visited = mainCtx.dirsVisited;
+    for (auto& wctx : workerCtxs)
+        visited += wctx->dirsVisited;
+    std::sort(deadlineSkipped.begin(), deadlineSkipped.end());
+
+    clearProgress();
+    OutSink::print("\nDeadline %u sec reached, %zu dirs visited, %zu subtrees skipped, %.1f%% of dirs reached\n",
+        deadlineSec, visited, deadlineSkipped.size(), 100.0 * visited / std::max((size_t)1, visited + deadlineSkipped.size()));
+    for (size_t idx = 0; idx < deadlineSkipped.size() && idx < DEADLINE_LIST; idx++)
+        OutSink::print("  skipped %s\n", deadlineSkipped[idx].c_str());
+    if (deadlineSkipped.size() > DEADLINE_LIST)
+        OutSink::print("  ... %zu more\n", deadlineSkipped.size() - DEADLINE_LIST);
+    OutSink::flush();
+}
+
+//-------------------------------------------------------------------------------------------------
+// -watch report, one usage report per argument and a grand total.
+void printWatch(const Watcher& watcher) {
+    clearProgress();
+    OutSink::put('\n');
+    printTime(time(nullptr), "%Y-%m-%d %H:%M:%S");
+    if (watcher.unwatchedCount() != 0)
+        OutSink::print("  (%zu dirs unwatched, re-listed each report)", watcher.unwatchedCount());
+    OutSink::put('\n');
+
+    for (size_t idx = 0; idx < watcher.rootCount(); idx++) {
+        clearUsage();
+        watcher.getTotals(idx, duList);
+        printUsage(watcher.root(idx));
+    }
+    clearUsage();
+    printUsage("");
+    gtotalCount = gtotalLinks = gtotalDiskSize = gtotalFileSize = 0;
+    gtotalDetail = DuInfo();
+}
+
 //-------------------------------------------------------------------------------------------------
 template <class TT> void appendAt(size_t pos, std::vector<TT>& list, TT data, TT filler) {
     while (list.size() < pos)
@@ -1054,21 +2061,49 @@ void buildTable(const std::string& filepath) {
     // Merge DuList into a multi-column table
     size_t column = filePaths.size();
     filePaths.push_back(filepath);
-    for (const auto & duItem : duList) {
-        appendAt(column, tableList[duItem.second.ext], duItem.second, emptyDu);
+    std::vector<DuInfo> infos;
+    duList.getInfos(infos);
+    if (estimateRate != 0)
+        DuInfo::extrapolate(infos);
+    for (const auto & info : infos) {
+        appendAt(column, tableList[info.ext], info, emptyDu);
     }
 }
 
 void printTable() {
-    printf("Table of %s\n", tableType.c_str());
-    std::vector<size_t> totals(filePaths.size(), 0);
+    OutSink::print("Table of %s\n", tableType.c_str());
+    // -table=age has a size column per age bucket for each path.
+    const unsigned colsPerPath = (tableType[0] == 'a') ? AgeSums::BUCKETS : 1;
+    const int width = (colsPerPath == 1) ? 10 : 14;
+    std::vector<size_t> totals(filePaths.size() * colsPerPath, 0);
+    if (colsPerPath != 1) {
+        OutSink::print("%10.10s  ", "");
+        for (unsigned col = 0; col < filePaths.size(); col++) {
+            for (unsigned idx = 0; idx < AgeSums::BUCKETS; idx++) {
+                char label[32];
+                if (idx + 1 < AgeSums::BUCKETS)
+                    snprintf(label, sizeof(label), "%u-%ud", AgeSums::DAYS[idx], AgeSums::DAYS[idx + 1]);
+                else
+                    snprintf(label, sizeof(label), "%ud+", AgeSums::DAYS[idx]);
+                OutSink::print("%*s", width, label);
+            }
+        }
+        OutSink::put('\n');
+    }
 
     // Print merged table
     for (const auto & duItem : tableList) {
-        printf("%10.10s  ", duItem.first.c_str());
+        OutSink::print("%10.10s  ", duItem.first.c_str());
         const std::vector<DuInfo>& duList = duItem.second;
         unsigned col = 0;
         for (auto iter = duList.cbegin(); iter != duList.cend(); iter++) {
+            if (colsPerPath != 1) {
+                for (unsigned idx = 0; idx < AgeSums::BUCKETS; idx++) {
+                    OutSink::print("%*lu", width, (unsigned long)iter->age.sizes[idx]);
+                    totals[col++] += iter->age.sizes[idx];
+                }
+                continue;
+            }
             size_t value;
             switch (tableType[0]) {
                 default:
@@ -1080,19 +2115,21 @@ void printTable() {
                 case 'h': value = iter->hardlinks; break;
             }
 
-            printf("%10lu", (unsigned long)value);
+            OutSink::print("%10lu", (unsigned long)value);
             totals[col++] += value;
         }
        
-        printf("\n");
+        OutSink::put('\n');
     }
     
-    printf("%10.10s  ", "_TOTAL");
-    for (unsigned col = 0; col < filePaths.size(); col++) {
-        printf("%10lu", (unsigned long)totals[col]);
+    OutSink::print("%10.10s  ", "_TOTAL");
+    for (unsigned col = 0; col < totals.size(); col++) {
+        OutSink::print("%*lu", width, (unsigned long)totals[col]);
     }
-    std::cout << "\nPaths:\n";
+    OutSink::write("\nPaths:\n");
     for (auto item : filePaths) {
-        std::cout << item << std::endl;
+        OutSink::write(item);
+        OutSink::put('\n');
     }
+    OutSink::flush();
 }
@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "outsink.hpp"
+
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+
+static const size_t SINK_SIZE = 1 << 20;
+
+//-------------------------------------------------------------------------------------------------
+struct Sink {
+    std::mutex lock;    // verbose output can come from scan workers
+    std::string buf;
+    bool unbuffered = false;
+
+    void writeOut() {
+        if (!buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), stdout);
+            buf.clear();
+        }
+        fflush(stdout);
+    }
+    ~Sink() {
+        writeOut();     // exit without a final report (abort, error)
+    }
+};
+static Sink sink;
+
+//-------------------------------------------------------------------------------------------------
+void OutSink::setUnbuffered(bool unbuffered) {
+    std::lock_guard<std::mutex> guard(sink.lock);
+    sink.writeOut();
+    sink.unbuffered = unbuffered;
+}
+
+//-------------------------------------------------------------------------------------------------
+void OutSink::write(const char* data, size_t len) {
+    std::lock_guard<std::mutex> guard(sink.lock);
+    if (sink.buf.capacity() < SINK_SIZE)
+        sink.buf.reserve(SINK_SIZE);
+    if (sink.buf.size() + len > SINK_SIZE)
+        sink.writeOut();
+    if (len >= SINK_SIZE) {
+        fwrite(data, 1, len, stdout);
+    } else {
+        sink.buf.append(data, len);
+    }
+    if (sink.unbuffered)
+        sink.writeOut();
+}
+
+//-------------------------------------------------------------------------------------------------
+void OutSink::print(const char* fmt, ...) {
+    char local[1024];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(local, sizeof(local), fmt, args);
+    va_end(args);
+    if (len < 0)
+        return;
+    if ((size_t)len < sizeof(local)) {
+        write(local, len);
+    } else {
+        std::string big(len + 1, '\0');
+        va_start(args, fmt);
+        vsnprintf(&big[0], big.size(), fmt, args);
+        va_end(args);
+        write(big.data(), len);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void OutSink::flush() {
+    std::lock_guard<std::mutex> guard(sink.lock);
+    sink.writeOut();
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Buffered stdout writer shared by all report output (usage rows, tables, side-by-side,
+// verbose and file lists). Output is collected in a large buffer which is written when
+// full or at report boundaries (flush), instead of a flush per line.
+// -unbuffered writes and flushes every call, for interactive use.
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+//-------------------------------------------------------------------------------------------------
+class OutSink {
+public:
+    static void setUnbuffered(bool unbuffered);
+
+    static void write(const char* data, size_t len);
+    static void write(const std::string& str) { write(str.data(), str.length()); }
+    static void put(char chr) { write(&chr, 1); }
+#if defined(__GNUC__)
+    static void print(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+#else
+    static void print(const char* fmt, ...);
+#endif
+
+    // Write buffered output to stdout, called at the end of each report.
+    static void flush();
+};
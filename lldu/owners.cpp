@@ -0,0 +1,55 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "owners.hpp"
+
+#include <errno.h>
+#ifndef HAVE_WIN
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+#endif
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+const std::string& OwnerNames::lookup(NameMap& names, Last& last, unsigned id, bool isGroup) {
+    if (last.name != nullptr && last.id == id)
+        return *last.name;
+    auto iter = names.find(id);
+    if (iter == names.end())
+        iter = names.emplace(id, resolve(id, isGroup)).first;
+    last.id = id;
+    last.name = &iter->second;
+    return iter->second;
+}
+
+//-------------------------------------------------------------------------------------------------
+std::string OwnerNames::resolve(unsigned id, bool isGroup) {
+#ifndef HAVE_WIN
+    long bufSize = sysconf(isGroup ? _SC_GETGR_R_SIZE_MAX : _SC_GETPW_R_SIZE_MAX);
+    std::vector<char> buf((bufSize > 0) ? bufSize : 16384);
+    for (;;) {
+        int err;
+        const char* name = nullptr;
+        if (isGroup) {
+            struct group grp;
+            struct group* found = nullptr;
+            err = getgrgid_r(id, &grp, buf.data(), buf.size(), &found);
+            if (err == 0 && found != nullptr)
+                name = found->gr_name;
+        } else {
+            struct passwd pwd;
+            struct passwd* found = nullptr;
+            err = getpwuid_r(id, &pwd, buf.data(), buf.size(), &found);
+            if (err == 0 && found != nullptr)
+                name = found->pw_name;
+        }
+        if (name != nullptr)
+            return name;
+        if (err != ERANGE || buf.size() >= (1u << 20))
+            break;
+        buf.resize(buf.size() * 2);
+    }
+#endif
+    return std::to_string(id);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -group=uid|gid|ext+uid, user and group names for owner ids.
+//
+// Each id is resolved once with the reentrant getpwuid_r / getgrgid_r and kept, so a scan
+// of millions of files makes one passwd lookup per distinct owner. Files in a directory
+// usually share an owner, so the last id is checked before the map. Each scan thread
+// keeps its own cache, no locking. Ids without a name (and Windows) use the number.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+//-------------------------------------------------------------------------------------------------
+class OwnerNames {
+public:
+    const std::string& user(unsigned uid) { return lookup(users, lastUser, uid, false); }
+    const std::string& group(unsigned gid) { return lookup(groups, lastGroup, gid, true); }
+
+private:
+    typedef std::unordered_map<unsigned, std::string> NameMap;
+    struct Last {
+        unsigned id;
+        const std::string* name;    // map nodes are stable
+        Last() : id(0), name(nullptr) {}
+    };
+
+    static const std::string& lookup(NameMap& names, Last& last, unsigned id, bool isGroup);
+    static std::string resolve(unsigned id, bool isGroup);
+
+    NameMap users;
+    NameMap groups;
+    Last lastUser;
+    Last lastGroup;
+};
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "progress.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+static std::thread reporter;
+static std::mutex progressLock;         // guards state below and the stderr progress line
+static std::condition_variable progressCond;
+static bool running = false;
+static std::string curDir;
+static size_t lineLen = 0;
+static std::atomic<size_t> totalFiles(0);
+static std::atomic<size_t> totalBytes(0);
+
+//-------------------------------------------------------------------------------------------------
+static void fmtBytes(char* buf, size_t bufLen, size_t bytes) {
+    const char* units[] = { "B", "KB", "MB", "GB", "TB", "PB" };
+    double value = (double)bytes;
+    unsigned unit = 0;
+    while (value >= 1024 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+        value /= 1024;
+        unit++;
+    }
+    snprintf(buf, bufLen, (unit == 0) ? "%.0f %s" : "%.1f %s", value, units[unit]);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void reportLoop(unsigned seconds) {
+    auto startTm = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(progressLock);
+    while (running) {
+        progressCond.wait_for(lock, std::chrono::seconds(seconds));
+        if (!running)
+            break;
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTm).count();
+        size_t files = totalFiles.load(std::memory_order_relaxed);
+        char bytesStr[32];
+        fmtBytes(bytesStr, sizeof(bytesStr), totalBytes.load(std::memory_order_relaxed));
+        char line[128];
+        int len = snprintf(line, sizeof(line), "%lu(sec) %lu files %lu/sec %s ",
+            (unsigned long)elapsed, (unsigned long)files,
+            (unsigned long)(elapsed > 0 ? files / elapsed : 0), bytesStr);
+
+        if (lineLen > 0)
+            std::cerr << std::string(lineLen, ' ') << "\r";
+        std::cerr << line << curDir << "  \r" << std::flush;
+        lineLen = len + curDir.length() + 2;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void Progress::start(unsigned seconds) {
+    std::lock_guard<std::mutex> guard(progressLock);
+    if (running)
+        return;
+    running = true;
+    reporter = std::thread(reportLoop, seconds);
+}
+
+//-------------------------------------------------------------------------------------------------
+void Progress::stop() {
+    {
+        std::lock_guard<std::mutex> guard(progressLock);
+        if (!running)
+            return;
+        running = false;
+    }
+    progressCond.notify_all();
+    reporter.join();
+    clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+void Progress::setDir(const lstring& dirname) {
+    std::lock_guard<std::mutex> guard(progressLock);
+    curDir = dirname;
+}
+
+//-------------------------------------------------------------------------------------------------
+void Progress::add(size_t files, size_t bytes) {
+    totalFiles.fetch_add(files, std::memory_order_relaxed);
+    totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+void Progress::clear() {
+    std::lock_guard<std::mutex> guard(progressLock);
+    if (lineLen > 0)
+        std::cerr << std::string(lineLen, ' ') << "\r" << std::flush;
+    lineLen = 0;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -progress reporter. A timer thread prints elapsed time, files, files/sec, bytes and the
+// directory being scanned to stderr, so the scan loop does no clock or string work.
+// Scanners hand over counts once per directory with add().
+
+#pragma once
+
+#include "ll_stdhdr.hpp"
+
+//-------------------------------------------------------------------------------------------------
+class Progress {
+public:
+    static void start(unsigned seconds);
+    static void stop();
+
+    static void setDir(const lstring& dirname);
+    static void add(size_t files, size_t bytes);
+    // Erase progress line before other output.
+    static void clear();
+};
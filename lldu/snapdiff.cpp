@@ -0,0 +1,155 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "snapdiff.hpp"
+#include "snapshot.hpp"
+#include "outsink.hpp"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+struct Delta {
+    int64_t count;
+    int64_t fileSize;
+    int64_t diskSize;
+    Delta() : count(0), fileSize(0), diskSize(0) {}
+
+    bool empty() const { return count == 0 && fileSize == 0 && diskSize == 0; }
+};
+
+struct DirDelta {
+    std::string path;
+    Delta delta;
+};
+
+// Larger absolute change sorts first, ties by path.
+static bool growthBefore(const Delta& lhs, const std::string& lhsName, const Delta& rhs, const std::string& rhsName) {
+    int64_t lhsDisk = std::abs(lhs.diskSize), rhsDisk = std::abs(rhs.diskSize);
+    if (lhsDisk != rhsDisk)
+        return lhsDisk > rhsDisk;
+    int64_t lhsSize = std::abs(lhs.fileSize), rhsSize = std::abs(rhs.fileSize);
+    if (lhsSize != rhsSize)
+        return lhsSize > rhsSize;
+    int64_t lhsCount = std::abs(lhs.count), rhsCount = std::abs(rhs.count);
+    if (lhsCount != rhsCount)
+        return lhsCount > rhsCount;
+    return lhsName < rhsName;
+}
+
+struct DirDeltaBefore {
+    bool operator()(const DirDelta& lhs, const DirDelta& rhs) const {
+        return growthBefore(lhs.delta, lhs.path, rhs.delta, rhs.path);
+    }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Add sign * directory's own file totals to dirDelta and per extension deltas.
+static void addDir(const SnapshotReader& snap, const SnapDirRec& rec, int sign, Delta& dirDelta,
+        std::unordered_map<std::string, Delta>& extDeltas) {
+    const SnapExtRec* exts = snap.exts(rec);
+    for (uint32_t idx = 0; idx < rec.extCnt; idx++) {
+        const SnapExtRec& ext = exts[idx];
+        Delta& extDelta = extDeltas[std::string(snap.text(ext.nameOff, ext.nameLen))];
+        extDelta.count += sign * (int64_t)ext.count;
+        extDelta.fileSize += sign * (int64_t)ext.fileSize;
+        extDelta.diskSize += sign * (int64_t)ext.diskSize;
+        dirDelta.count += sign * (int64_t)ext.count;
+        dirDelta.fileSize += sign * (int64_t)ext.fileSize;
+        dirDelta.diskSize += sign * (int64_t)ext.diskSize;
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+static void printDelta(const Delta& delta, const std::string& name) {
+    OutSink::print("%+10lld\t%+15lld\t%+15lld\t%s\n",
+        (long long)delta.count, (long long)delta.fileSize, (long long)delta.diskSize, name.c_str());
+}
+
+//-------------------------------------------------------------------------------------------------
+bool SnapshotDiff::report(const char* oldFile, const char* newFile, size_t maxRows) {
+    SnapshotReader oldSnap;
+    SnapshotReader newSnap;
+    if (!oldSnap.open(oldFile, 0)) {
+        std::cerr << "Unable to read snapshot " << oldFile << std::endl;
+        return false;
+    }
+    if (!newSnap.open(newFile, 0)) {
+        std::cerr << "Unable to read snapshot " << newFile << std::endl;
+        return false;
+    }
+
+    // Min heap on growth, top holds the smallest of the kept rows.
+    std::priority_queue<DirDelta, std::vector<DirDelta>, DirDeltaBefore> topDirs;
+    std::unordered_map<std::string, Delta> extDeltas;
+    Delta total;
+
+    size_t oldIdx = 0;
+    size_t newIdx = 0;
+    while (oldIdx < oldSnap.dirCount() || newIdx < newSnap.dirCount()) {
+        const SnapDirRec* oldRec = (oldIdx < oldSnap.dirCount()) ? &oldSnap.dir(oldIdx) : nullptr;
+        const SnapDirRec* newRec = (newIdx < newSnap.dirCount()) ? &newSnap.dir(newIdx) : nullptr;
+        int cmp = (oldRec == nullptr) ? 1 : (newRec == nullptr) ? -1
+            : oldSnap.path(*oldRec).compare(newSnap.path(*newRec));
+
+        Delta dirDelta;
+        std::string_view path;
+        if (cmp <= 0) {
+            addDir(oldSnap, *oldRec, -1, dirDelta, extDeltas);
+            path = oldSnap.path(*oldRec);
+            oldIdx++;
+        }
+        if (cmp >= 0) {
+            addDir(newSnap, *newRec, 1, dirDelta, extDeltas);
+            path = newSnap.path(*newRec);
+            newIdx++;
+        }
+
+        if (dirDelta.empty())
+            continue;
+        total.count += dirDelta.count;
+        total.fileSize += dirDelta.fileSize;
+        total.diskSize += dirDelta.diskSize;
+        if (maxRows == 0) {
+        } else if (topDirs.size() < maxRows) {
+            topDirs.push(DirDelta{ std::string(path), dirDelta });
+        } else {
+            std::string name(path);
+            if (growthBefore(dirDelta, name, topDirs.top().delta, topDirs.top().path)) {
+                topDirs.pop();
+                topDirs.push(DirDelta{ std::move(name), dirDelta });
+            }
+        }
+    }
+
+    std::vector<DirDelta> dirRows;
+    dirRows.reserve(topDirs.size());
+    while (!topDirs.empty()) {
+        dirRows.push_back(topDirs.top());
+        topDirs.pop();
+    }
+    std::reverse(dirRows.begin(), dirRows.end());
+
+    std::vector<DirDelta> extRows;
+    for (const auto& ext : extDeltas) {
+        if (!ext.second.empty())
+            extRows.push_back(DirDelta{ ext.first, ext.second });
+    }
+    std::sort(extRows.begin(), extRows.end(), DirDeltaBefore());
+
+    OutSink::print("%10s\t%15s\t%15s\t%s\n", "Count", "Size", "Disk", "Directory (own files)");
+    for (const DirDelta& row : dirRows)
+        printDelta(row.delta, row.path);
+    OutSink::print("\n%10s\t%15s\t%15s\t%s\n", "Count", "Size", "Disk", "Ext");
+    for (const DirDelta& row : extRows)
+        printDelta(row.delta, row.path);
+    printDelta(total, "Total");
+    OutSink::flush();
+    return true;
+}
@@ -0,0 +1,20 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -diff=<old> <new> growth report between two -snapshot files.
+//
+// Both snapshots keep their directory records sorted by path, so they are merge-joined in
+// one pass without loading either file. Each directory's own files are compared, and the
+// directories with the largest absolute change are kept in a bounded heap. Extension
+// deltas are summed in a map with one entry per extension.
+
+#pragma once
+
+#include <stddef.h>
+
+//-------------------------------------------------------------------------------------------------
+class SnapshotDiff {
+public:
+    // Print the top maxRows directory deltas and all extension deltas, sorted by absolute
+    // disk size change. Returns false if a snapshot could not be read.
+    static bool report(const char* oldFile, const char* newFile, size_t maxRows);
+};
@@ -0,0 +1,267 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef HAVE_WIN
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SNAP_MAGIC[8] = { 'L', 'L', 'D', 'U', 'S', 'N', 'A', 'P' };
+static const uint32_t SNAP_VERSION = 1;
+static const uint32_t SNAP_BYTE_ORDER = 0x01020304;
+
+//-------------------------------------------------------------------------------------------------
+// FNV-1a, stable between runs and builds.
+uint64_t snapshotKey(const std::string& options) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char chr : options) {
+        hash ^= chr;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash ? hash : 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+void SnapshotWriter::add(SnapDir&& dir) {
+    std::lock_guard<std::mutex> guard(lock);
+    dirs.push_back(std::move(dir));
+}
+
+//-------------------------------------------------------------------------------------------------
+bool SnapshotWriter::write(const char* filename, uint64_t optionsKey, int64_t createTime) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::sort(dirs.begin(), dirs.end(), [](const SnapDir& a, const SnapDir& b) { return a.path < b.path; });
+    // Same directory reached twice (overlapping arguments), keep first.
+    dirs.erase(std::unique(dirs.begin(), dirs.end(),
+        [](const SnapDir& a, const SnapDir& b) { return a.path == b.path; }), dirs.end());
+
+    std::vector<SnapDirRec> dirRecs;
+    std::vector<SnapExtRec> extRecs;
+    std::vector<SnapSubRec> subRecs;
+    std::string strings;
+    dirRecs.reserve(dirs.size());
+
+    for (const SnapDir& dir : dirs) {
+        SnapDirRec rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.pathOff = strings.size();
+        rec.pathLen = (uint32_t)dir.path.size();
+        strings += dir.path;
+        rec.flags = (dir.ctime >= createTime || dir.mtime >= createTime) ? SnapDirRec::FLAG_RACY : 0;
+        rec.dev = dir.dev;
+        rec.ino = dir.ino;
+        rec.mtime = dir.mtime;
+        rec.ctime = dir.ctime;
+        rec.fileCount = dir.fileCount;
+        rec.extFirst = extRecs.size();
+        rec.extCnt = (uint32_t)dir.exts.size();
+        for (const auto& ext : dir.exts) {
+            SnapExtRec extRec;
+            memset(&extRec, 0, sizeof(extRec));
+            extRec.nameOff = strings.size();
+            extRec.nameLen = (uint32_t)ext.first.size();
+            strings += ext.first;
+            extRec.count = ext.second.count;
+            extRec.diskSize = ext.second.diskSize;
+            extRec.fileSize = ext.second.fileSize;
+            extRec.hardlinks = ext.second.hardlinks;
+            extRec.softlinks = ext.second.softlinks;
+            extRecs.push_back(extRec);
+        }
+        rec.subFirst = subRecs.size();
+        rec.subCnt = (uint32_t)dir.subdirs.size();
+        for (const std::string& sub : dir.subdirs) {
+            SnapSubRec subRec;
+            memset(&subRec, 0, sizeof(subRec));
+            subRec.nameOff = strings.size();
+            subRec.nameLen = (uint32_t)sub.size();
+            strings += sub;
+            subRecs.push_back(subRec);
+        }
+        dirRecs.push_back(rec);
+    }
+
+    SnapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAP_MAGIC, sizeof(header.magic));
+    header.version = SNAP_VERSION;
+    header.byteOrder = SNAP_BYTE_ORDER;
+    header.optionsKey = optionsKey;
+    header.createTime = createTime;
+    header.dirCount = dirRecs.size();
+    header.dirOffset = sizeof(header);
+    header.extCount = extRecs.size();
+    header.extOffset = header.dirOffset + dirRecs.size() * sizeof(SnapDirRec);
+    header.subCount = subRecs.size();
+    header.subOffset = header.extOffset + extRecs.size() * sizeof(SnapExtRec);
+    header.strSize = strings.size();
+    header.strOffset = header.subOffset + subRecs.size() * sizeof(SnapSubRec);
+
+    std::string tmpName = std::string(filename) + ".tmp";
+    FILE* out = fopen(tmpName.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+    bool okay = fwrite(&header, sizeof(header), 1, out) == 1
+        && fwrite(dirRecs.data(), sizeof(SnapDirRec), dirRecs.size(), out) == dirRecs.size()
+        && fwrite(extRecs.data(), sizeof(SnapExtRec), extRecs.size(), out) == extRecs.size()
+        && fwrite(subRecs.data(), sizeof(SnapSubRec), subRecs.size(), out) == subRecs.size()
+        && fwrite(strings.data(), 1, strings.size(), out) == strings.size();
+    okay = (fclose(out) == 0) && okay;
+#ifdef HAVE_WIN
+    if (okay)
+        remove(filename);
+#endif
+    if (!okay || rename(tmpName.c_str(), filename) != 0) {
+        remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+SnapshotReader::SnapshotReader() :
+    mapAddr(nullptr), mapSize(0), header(nullptr), dirs(nullptr), extRecs(nullptr), subRecs(nullptr),
+    strings(nullptr) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+//-------------------------------------------------------------------------------------------------
+void SnapshotReader::close() {
+#ifndef HAVE_WIN
+    if (mapAddr != nullptr)
+        munmap(mapAddr, mapSize);
+#endif
+    mapAddr = nullptr;
+    mapSize = 0;
+    data.clear();
+    header = nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+// True if count items of itemSize at off lie inside size bytes, without overflow.
+static bool fits(uint64_t off, uint64_t count, uint64_t itemSize, uint64_t size) {
+    return off <= size && count <= (size - off) / itemSize;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Every string and record range a reader follows must lie inside its table, a truncated or
+// corrupt file is rejected here instead of read out of bounds later.
+static bool validRecords(const char* base, const SnapHeader& head) {
+    const SnapDirRec* dirs = (const SnapDirRec*)(base + head.dirOffset);
+    const SnapExtRec* exts = (const SnapExtRec*)(base + head.extOffset);
+    const SnapSubRec* subs = (const SnapSubRec*)(base + head.subOffset);
+    for (uint64_t idx = 0; idx < head.dirCount; idx++) {
+        const SnapDirRec& rec = dirs[idx];
+        if (!fits(rec.pathOff, rec.pathLen, 1, head.strSize)
+                || !fits(rec.extFirst, rec.extCnt, 1, head.extCount)
+                || !fits(rec.subFirst, rec.subCnt, 1, head.subCount))
+            return false;
+    }
+    for (uint64_t idx = 0; idx < head.extCount; idx++) {
+        if (!fits(exts[idx].nameOff, exts[idx].nameLen, 1, head.strSize))
+            return false;
+    }
+    for (uint64_t idx = 0; idx < head.subCount; idx++) {
+        if (!fits(subs[idx].nameOff, subs[idx].nameLen, 1, head.strSize))
+            return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool SnapshotReader::open(const char* filename, uint64_t optionsKey) {
+    close();
+    const char* base = nullptr;
+    size_t size = 0;
+
+#ifndef HAVE_WIN
+    int fd = ::open(filename, O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SnapHeader)) {
+        void* addr = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapAddr = addr;
+            mapSize = (size_t)info.st_size;
+            base = (const char*)addr;
+            size = mapSize;
+        }
+    }
+    ::close(fd);
+#else
+    FILE* in = fopen(filename, "rb");
+    if (in == nullptr)
+        return false;
+    char buf[1 << 16];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0)
+        data.insert(data.end(), buf, buf + got);
+    fclose(in);
+    base = data.data();
+    size = data.size();
+#endif
+
+    if (base == nullptr || size < sizeof(SnapHeader)) {
+        close();
+        return false;
+    }
+
+    const SnapHeader* head = (const SnapHeader*)base;
+    bool valid = memcmp(head->magic, SNAP_MAGIC, sizeof(SNAP_MAGIC)) == 0
+        && head->version == SNAP_VERSION
+        && head->byteOrder == SNAP_BYTE_ORDER
+        && (optionsKey == 0 || head->optionsKey == optionsKey)
+        && head->dirOffset % alignof(SnapDirRec) == 0
+        && head->extOffset % alignof(SnapExtRec) == 0
+        && head->subOffset % alignof(SnapSubRec) == 0
+        && fits(head->dirOffset, head->dirCount, sizeof(SnapDirRec), size)
+        && fits(head->extOffset, head->extCount, sizeof(SnapExtRec), size)
+        && fits(head->subOffset, head->subCount, sizeof(SnapSubRec), size)
+        && fits(head->strOffset, head->strSize, 1, size)
+        && validRecords(base, *head);
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    header = head;
+    dirs = (const SnapDirRec*)(base + head->dirOffset);
+    extRecs = (const SnapExtRec*)(base + head->extOffset);
+    subRecs = (const SnapSubRec*)(base + head->subOffset);
+    strings = base + head->strOffset;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+const SnapDirRec* SnapshotReader::find(std::string_view path) const {
+    if (!isOpen())
+        return nullptr;
+    const SnapDirRec* first = dirs;
+    const SnapDirRec* last = dirs + header->dirCount;
+    const SnapDirRec* found = std::lower_bound(first, last, path,
+        [this](const SnapDirRec& rec, std::string_view key) { return this->path(rec) < key; });
+    return (found != last && this->path(*found) == path) ? found : nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+void SnapshotReader::roots(std::vector<std::string_view>& paths) const {
+    for (size_t idx = 0; idx < dirCount(); idx++) {
+        std::string_view dirPath = path(dirs[idx]);
+        size_t slash = dirPath.find_last_of("/\\", dirPath.length() - 2);
+        if (dirPath.length() < 2 || slash == std::string_view::npos
+                || (find(dirPath.substr(0, slash)) == nullptr && find(dirPath.substr(0, slash + 1)) == nullptr))
+            paths.push_back(dirPath);
+    }
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -snapshot=<file> scan index for incremental rescans.
+//
+// For every scanned directory the snapshot keeps its device, inode, mtime and ctime, the
+// per extension totals of its own files and the names of its subdirectories.
+// A later scan which finds a directory with the same stamps reuses those totals and
+// recurses into the saved subdirectories without reading or stat'ing the directory's files.
+// Changes to a file's content which do not touch its directory are not seen until the
+// directory itself changes.
+//
+// File layout, native byte order, all offsets from start of file:
+//     SnapHeader
+//     SnapDirRec[dirCount]    sorted by path (byte compare)
+//     SnapExtRec[extCount]    each directory's entries are contiguous
+//     SnapSubRec[subCount]
+//     string pool             paths, extensions and subdirectory names
+// Fixed size records let the file be used in place (memory mapped) without parsing.
+
+#pragma once
+
+#include "dulist.hpp"
+
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+struct SnapHeader {
+    char magic[8];          // "LLDUSNAP"
+    uint32_t version;
+    uint32_t byteOrder;     // 0x01020304 written natively
+    uint64_t optionsKey;    // hash of options which change the totals
+    int64_t createTime;     // scan start, seconds
+    uint64_t dirCount;
+    uint64_t dirOffset;
+    uint64_t extCount;
+    uint64_t extOffset;
+    uint64_t subCount;
+    uint64_t subOffset;
+    uint64_t strSize;
+    uint64_t strOffset;
+};
+
+struct SnapDirRec {
+    uint64_t pathOff;       // into string pool
+    uint32_t pathLen;
+    uint32_t flags;         // FLAG_RACY
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime;
+    int64_t ctime;
+    uint64_t fileCount;     // own files
+    uint64_t extFirst;
+    uint32_t extCnt;
+    uint32_t subCnt;
+    uint64_t subFirst;
+    static const uint32_t FLAG_RACY = 1;  // changed during the scan, never reused
+};
+
+struct SnapExtRec {
+    uint64_t nameOff;
+    uint32_t nameLen;
+    uint32_t pad;
+    uint64_t count;
+    uint64_t diskSize;
+    uint64_t fileSize;
+    uint64_t hardlinks;
+    uint64_t softlinks;
+};
+
+struct SnapSubRec {
+    uint64_t nameOff;
+    uint32_t nameLen;
+    uint32_t pad;
+};
+
+//-------------------------------------------------------------------------------------------------
+// One directory's data, collected while scanning.
+struct SnapDir {
+    std::string path;
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime;
+    int64_t ctime;
+    uint64_t fileCount;
+    std::vector<std::pair<std::string, DuSums>> exts;
+    std::vector<std::string> subdirs;
+};
+
+//-------------------------------------------------------------------------------------------------
+class SnapshotWriter {
+public:
+    void add(SnapDir&& dir);      // thread safe
+    // Sort and write to file (via a temporary file and rename), false on error.
+    bool write(const char* filename, uint64_t optionsKey, int64_t createTime);
+
+private:
+    std::mutex lock;
+    std::vector<SnapDir> dirs;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Read only view of a snapshot file, memory mapped where available.
+class SnapshotReader {
+public:
+    SnapshotReader();
+    ~SnapshotReader();
+
+    // Open and validate file, optionsKey 0 accepts any options.
+    bool open(const char* filename, uint64_t optionsKey);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    size_t dirCount() const { return isOpen() ? (size_t)header->dirCount : 0; }
+    const SnapDirRec& dir(size_t idx) const { return dirs[idx]; }
+    std::string_view path(const SnapDirRec& rec) const { return text(rec.pathOff, rec.pathLen); }
+    const SnapExtRec* exts(const SnapDirRec& rec) const { return extRecs + rec.extFirst; }
+    const SnapSubRec* subdirs(const SnapDirRec& rec) const { return subRecs + rec.subFirst; }
+    std::string_view text(uint64_t off, uint32_t len) const { return std::string_view(strings + off, len); }
+
+    // Binary search by path, nullptr if not present.
+    const SnapDirRec* find(std::string_view path) const;
+    // Paths whose parent directory is not in the snapshot, the scan's arguments.
+    void roots(std::vector<std::string_view>& paths) const;
+
+private:
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    void* mapAddr;
+    size_t mapSize;
+    std::vector<char> data;     // when not mapped
+    const SnapHeader* header;
+    const SnapDirRec* dirs;
+    const SnapExtRec* extRecs;
+    const SnapSubRec* subRecs;
+    const char* strings;
+};
+
+uint64_t snapshotKey(const std::string& options);
@@ -10,6 +10,12 @@
 #include <iomanip>
 #include <string>
 #include <format>
+#include <map>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
 
 #ifdef HAVE_WIN
 #define byte win_byte_override  // Fix for c++ v17
@@ -1123,3 +1129,72 @@ void Storage::ListStorageSizes() {
     std::cout << std::endl;
 }
 #endif
+
+#ifdef __linux__
+// mountinfo writes space, tab, newline and backslash in paths as octal escapes, ex: \040
+static std::string unescapeMount(const std::string& field) {
+    std::string out;
+    out.reserve(field.length());
+    for (size_t idx = 0; idx < field.length(); idx++) {
+        if (field[idx] == '\\' && idx + 3 < field.length()
+                && field[idx + 1] >= '0' && field[idx + 1] <= '3'
+                && field[idx + 2] >= '0' && field[idx + 2] <= '7'
+                && field[idx + 3] >= '0' && field[idx + 3] <= '7') {
+            out += (char)(((field[idx + 1] - '0') << 6) | ((field[idx + 2] - '0') << 3) | (field[idx + 3] - '0'));
+            idx += 3;
+        } else {
+            out += field[idx];
+        }
+    }
+    return out;
+}
+
+//-------------------------------------------------------------------------------------------------
+// /proc/self/mountinfo lines are
+//   id parentId major:minor root mountPoint options [optional...] - fsType source superOptions
+// A device mounted more than once (bind mounts) is labelled by its mount of the filesystem
+// root, shortest mount point first. Read once, -by-device labels each device it reports.
+std::string Storage::DeviceLabel(unsigned long long dev) {
+    struct Mount {
+        std::string label;
+        bool fsRoot;
+        size_t pointLen;
+    };
+    static std::map<unsigned long long, Mount> mounts;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true;
+        std::ifstream mountinfo("/proc/self/mountinfo");
+        std::string line;
+        while (std::getline(mountinfo, line)) {
+            std::istringstream iss(line);
+            std::string id, parentId, majMin, root, point, options, field, fsType, source;
+            if (!(iss >> id >> parentId >> majMin >> root >> point >> options))
+                continue;
+            while (iss >> field && field != "-") {
+            }
+            iss >> fsType >> source;
+            unsigned major, minor;
+            if (sscanf(majMin.c_str(), "%u:%u", &major, &minor) != 2)
+                continue;
+            point = unescapeMount(point);
+            source = unescapeMount(source);
+            Mount mount{ point + " (" + fsType + " " + source + ")", root == "/", point.length() };
+            auto iter = mounts.find(makedev(major, minor));
+            if (iter == mounts.end())
+                mounts.emplace(makedev(major, minor), mount);
+            else if ((mount.fsRoot && !iter->second.fsRoot)
+                    || (mount.fsRoot == iter->second.fsRoot && mount.pointLen < iter->second.pointLen))
+                iter->second = mount;
+        }
+    }
+    auto iter = mounts.find(dev);
+    if (iter != mounts.end())
+        return iter->second.label;
+    return "dev " + std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+}
+#else
+std::string Storage::DeviceLabel(unsigned long long dev) {
+    return "dev " + std::to_string(dev);
+}
+#endif
@@ -3,11 +3,13 @@
 
 
 #include "ll_stdhdr.hpp"
-
+#include <string>
 
 //-------------------------------------------------------------------------------------------------
 class Storage {
 
 public:
     static void ListStorageSizes();
+    // Mount point, type and source of a stat st_dev (Linux mountinfo), else the number.
+    static std::string DeviceLabel(unsigned long long dev);
 };
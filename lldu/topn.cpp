@@ -0,0 +1,37 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "topn.hpp"
+
+#include <algorithm>
+
+// Heap order puts the smallest value (then last name) at the front.
+static bool greaterEntry(const TopList::Entry& lhs, const TopList::Entry& rhs) {
+    return (lhs.value != rhs.value) ? lhs.value > rhs.value : lhs.name < rhs.name;
+}
+
+//-------------------------------------------------------------------------------------------------
+void TopList::add(uint64_t value, const std::string& name) {
+    if (!wants(value))
+        return;
+    if (heap.size() == limit) {
+        std::pop_heap(heap.begin(), heap.end(), greaterEntry);
+        heap.back().value = value;
+        heap.back().name = name;
+    } else {
+        heap.push_back(Entry{ value, name });
+    }
+    std::push_heap(heap.begin(), heap.end(), greaterEntry);
+}
+
+//-------------------------------------------------------------------------------------------------
+void TopList::merge(const TopList& other) {
+    for (const Entry& entry : other.heap)
+        add(entry.value, entry.name);
+}
+
+//-------------------------------------------------------------------------------------------------
+void TopList::getSorted(std::vector<Entry>& entries) const {
+    entries = heap;
+    std::sort(entries.begin(), entries.end(), greaterEntry);
+}
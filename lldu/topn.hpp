@@ -0,0 +1,42 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -top=N, the N largest files or directories seen by a scan.
+//
+// A min heap holds the current N largest, so the smallest kept entry is at the front.
+// wants() rejects anything not larger than it in O(1) before the caller builds a path
+// string, and add() replaces it in O(log N). Memory stays at N entries however large the
+// tree. A directory is added with its subtree total when its last subdirectory completes,
+// so the scan only holds the directories still in progress besides the lists.
+// Each scan thread keeps its own lists which are merged once at the end.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class TopList {
+public:
+    struct Entry {
+        uint64_t value;
+        std::string name;
+    };
+
+    TopList() : limit(0) {}
+
+    void setLimit(size_t _limit) { limit = _limit; }
+    bool wants(uint64_t value) const {
+        return limit != 0 && (heap.size() < limit || value > heap.front().value);
+    }
+    void add(uint64_t value, const std::string& name);
+    void merge(const TopList& other);
+    void clear() { heap.clear(); }
+
+    // Entries largest first.
+    void getSorted(std::vector<Entry>& entries) const;
+
+private:
+    size_t limit;
+    std::vector<Entry> heap;
+};
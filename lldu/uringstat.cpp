@@ -0,0 +1,246 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "uringstat.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_URING
+#endif
+#endif
+
+#ifdef HAVE_URING
+#include <linux/io_uring.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+static int uringSetup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+UringStat::UringStat(unsigned entries) :
+    ringFd(-1), sqEntries(0), cqEntries(0), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(MAP_FAILED),
+    sqRingSize(0), cqRingSize(0), sqesSize(0) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringFd = uringSetup(entries, &params);
+    if (ringFd < 0) {
+        ringFd = -1;
+        return;
+    }
+
+    sqEntries = params.sq_entries;
+    cqEntries = params.cq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        cqRing = sqRing;
+    else if (sqRing != MAP_FAILED)
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (cqRing != MAP_FAILED)
+        sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        release();
+        return;
+    }
+
+    char* sq = (char*)sqRing;
+    sqHead = (unsigned*)(sq + params.sq_off.head);
+    sqTail = (unsigned*)(sq + params.sq_off.tail);
+    sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + params.sq_off.array);
+    char* cq = (char*)cqRing;
+    cqHead = (unsigned*)(cq + params.cq_off.head);
+    cqTail = (unsigned*)(cq + params.cq_off.tail);
+    cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+}
+
+//-------------------------------------------------------------------------------------------------
+UringStat::~UringStat() {
+    release();
+}
+
+//-------------------------------------------------------------------------------------------------
+void UringStat::release() {
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (ringFd != -1)
+        close(ringFd);
+    ringFd = -1;
+    sqRing = cqRing = sqes = MAP_FAILED;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Probe once, io_uring may be compiled out, blocked by seccomp or lack IORING_OP_STATX.
+bool UringStat::available() {
+    static int state = -1;
+    if (state == -1) {
+        UringStat ring(2);
+        std::vector<const char*> names(1, ".");
+        std::vector<FileStat> stats;
+        std::vector<int> status;
+        state = ring.isOpen() && ring.statBatch(AT_FDCWD, names, DirScan::NEED_TYPE, stats, status)
+            && status[0] == 0;
+    }
+    return state == 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reap completed requests, copy their results out and free their slots. Returns the count.
+unsigned UringStat::reap(std::vector<FileStat>* stats, std::vector<int>* status) {
+    struct io_uring_cqe* cqeList = (struct io_uring_cqe*)cqes;
+    unsigned reaped = 0;
+    unsigned head = __atomic_load_n(cqHead, __ATOMIC_RELAXED);
+    unsigned cqTailNow = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != cqTailNow) {
+        const struct io_uring_cqe& cqe = cqeList[head & *cqMask];
+        unsigned slot = (unsigned)cqe.user_data;
+        if (status != nullptr) {
+            size_t idx = slotName[slot];
+            (*status)[idx] = (cqe.res < 0) ? -cqe.res : 0;
+            if (cqe.res >= 0)
+                copyStatx((*stats)[idx], slots[slot]);
+        }
+        freeSlots.push_back(slot);
+        head++;
+        reaped++;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Wait for requests the kernel already took, they still write into slots. If the ring can
+// not be waited on the slot buffer is left allocated rather than freed under the kernel.
+void UringStat::drain(unsigned inFlight) {
+    while (inFlight != 0) {
+        inFlight -= std::min(inFlight, reap(nullptr, nullptr));
+        if (inFlight == 0)
+            break;
+        if (uringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            new std::vector<struct statx>(std::move(slots));    // deliberately leaked
+            break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+bool UringStat::statBatch(int dirFd, const std::vector<const char*>& names, unsigned need,
+        std::vector<FileStat>& stats, std::vector<int>& status) {
+    if (ringFd == -1)
+        return false;
+
+    size_t count = names.size();
+    stats.resize(count);
+    status.assign(count, EIO);
+
+    // All slots are free between batches.
+    if (slots.size() != depth()) {
+        slots.resize(depth());
+        slotName.resize(depth());
+    }
+    freeSlots.clear();
+    for (unsigned slot = depth(); slot-- > 0; )
+        freeSlots.push_back(slot);
+
+    unsigned mask = statxMask(need);
+    size_t queued = 0;          // sqe's filled
+    size_t completed = 0;
+    unsigned unsubmitted = 0;   // filled but not yet taken by the kernel
+    unsigned inFlight = 0;      // taken by the kernel, not yet completed
+    struct io_uring_sqe* sqeList = (struct io_uring_sqe*)sqes;
+
+    while (completed < count) {
+        // Queue a request for each free slot.
+        unsigned tail = __atomic_load_n(sqTail, __ATOMIC_RELAXED);
+        while (queued < count && !freeSlots.empty()) {
+            unsigned slot = freeSlots.back();
+            freeSlots.pop_back();
+            slotName[slot] = queued;
+            unsigned idx = tail & *sqMask;
+            struct io_uring_sqe* sqe = &sqeList[idx];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirFd;
+            sqe->addr = (unsigned long long)(uintptr_t)names[queued];
+            sqe->len = mask;
+            sqe->off = (unsigned long long)(uintptr_t)&slots[slot];
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+            sqe->user_data = slot;
+            sqArray[idx] = idx;
+            tail++;
+            unsubmitted++;
+            queued++;
+        }
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+        int ret = uringEnter(ringFd, unsubmitted, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                drain(inFlight);
+                release();  // ring state unknown, caller falls back to sync stat
+                return false;
+            }
+            ret = 0;
+        }
+        unsubmitted -= (unsigned)ret;
+        inFlight += (unsigned)ret;
+        if (inFlight == 0) {
+            release();      // kernel refused to take any request, none in flight
+            return false;
+        }
+
+        unsigned reaped = reap(&stats, &status);
+        completed += reaped;
+        inFlight -= reaped;
+    }
+    return true;
+}
+
+#else
+
+//-------------------------------------------------------------------------------------------------
+UringStat::UringStat(unsigned entries) : ringFd(-1) {
+}
+
+UringStat::~UringStat() {
+}
+
+void UringStat::release() {
+}
+
+bool UringStat::available() {
+    return false;
+}
+
+bool UringStat::statBatch(int dirFd, const std::vector<const char*>& names, unsigned need,
+        std::vector<FileStat>& stats, std::vector<int>& status) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Batched statx through io_uring (Linux only, -engine=uring).
+//
+// A chunk of a directory listing is stat'ed as one batch of IORING_OP_STATX requests instead
+// of one syscall per file, which hides per-request latency on network filesystems. Each
+// request in flight owns one slot of a fixed statx buffer, one slot per ring entry.
+// Talks to the kernel directly (io_uring_setup/io_uring_enter), no liburing needed.
+// On other platforms, or kernels without io_uring, available() returns false.
+
+#pragma once
+
+#include "dirscan.hpp"
+
+#include <algorithm>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class UringStat {
+public:
+    UringStat(unsigned entries = 256);
+    ~UringStat();
+
+    // True if io_uring with statx support can be used on this system.
+    static bool available();
+
+    bool isOpen() const { return ringFd != -1; }
+    // Requests the ring holds at once, callers batch this many names.
+    unsigned depth() const { return std::min(sqEntries, cqEntries); }
+
+    // Stat names relative to dirFd without following links.
+    // status[idx] is 0 on success or an errno value. Returns false if the batch could not be
+    // run (caller should fall back to synchronous stat).
+    bool statBatch(int dirFd, const std::vector<const char*>& names, unsigned need,
+        std::vector<FileStat>& stats, std::vector<int>& status);
+
+private:
+    UringStat(const UringStat&) = delete;
+    UringStat& operator=(const UringStat&) = delete;
+    void release();
+    unsigned reap(std::vector<FileStat>* stats, std::vector<int>* status);
+    void drain(unsigned inFlight);
+
+    int ringFd;
+    unsigned sqEntries;
+    unsigned cqEntries;
+    void* sqRing;
+    void* cqRing;
+    void* sqes;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+
+    // Pointers into the mapped rings.
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    void* cqes;
+
+#ifdef HAVE_STATX
+    std::vector<struct statx> slots;    // statx result of the request in each slot
+#endif
+    std::vector<size_t> slotName;       // names index of the request in each slot
+    std::vector<unsigned> freeSlots;
+};
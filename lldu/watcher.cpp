@@ -0,0 +1,296 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "watcher.hpp"
+#include "dirscan.hpp"
+#include "signals.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#define HAVE_INOTIFY
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+
+//-------------------------------------------------------------------------------------------------
+Watcher::Watcher(ExamineFunc _examine, AcceptDirFunc _acceptDir) :
+    examine(_examine), acceptDir(_acceptDir), notifyFd(-1), unwatched(0), overflow(false) {
+#ifdef HAVE_INOTIFY
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+Watcher::~Watcher() {
+#ifdef HAVE_INOTIFY
+    if (notifyFd != -1)
+        close(notifyFd);
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+std::string Watcher::join(const std::string& dirPath, std::string_view name) {
+    std::string fullname = dirPath;     // same join as DirScan::fullName
+    if (fullname.empty() || fullname.back() != Directory_files::SLASH_CHAR)
+        fullname += Directory_files::SLASH_CHAR;
+    fullname.append(name);
+    return fullname;
+}
+
+//-------------------------------------------------------------------------------------------------
+void Watcher::addRoot(const lstring& root) {
+    roots.push_back(Root());
+    roots.back().path = root;
+    scanDir(root, 0, roots.size() - 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+void Watcher::getTotals(size_t rootIdx, DuList& totals) const {
+    roots[rootIdx].totals.forEach([&totals](std::string_view ext, const DuSums& sums) {
+        if (sums.count != 0)
+            totals[ext] += sums;
+    });
+}
+
+//-------------------------------------------------------------------------------------------------
+// Add directory and its subtree, watching each directory before it is listed so no
+// change after the listing is missed.
+void Watcher::scanDir(const std::string& path, unsigned depth, size_t rootIdx) {
+    if (Signals::aborted || dirs.find(path) != dirs.end())
+        return;
+    DirEntry& dir = dirs[path];
+    dir.wd = -1;
+    dir.depth = depth;
+    dir.rootIdx = rootIdx;
+#ifdef HAVE_INOTIFY
+    if (notifyFd != -1)
+        dir.wd = inotify_add_watch(notifyFd, path.c_str(), WATCH_MASK);
+#endif
+    if (dir.wd == -1)
+        unwatched++;    // ENOSPC at max_user_watches, re-listed every interval
+    else
+        watchPaths[dir.wd] = path;
+
+    DirScan directory(path);
+    lstring fullname;
+    while (!Signals::aborted && directory.more()) {
+        fullname.clear();
+        if (directory.is_directory()) {
+            directory.fullName(fullname);
+            if (acceptDir(fullname, directory.nameView(), depth)) {
+                dir.subdirs.insert(directory.name());
+                scanDir(fullname, depth + 1, rootIdx);
+            }
+        } else {
+            updateFile(dir, path, directory.name());
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// List directory again, for unwatched directories and after lost events.
+void Watcher::refreshDir(const std::string& path) {
+    auto iter = dirs.find(path);
+    if (iter == dirs.end())
+        return;
+    DirEntry& dir = iter->second;
+
+    std::set<std::string> seenFiles;
+    std::set<std::string> seenDirs;
+    DirScan directory(path);
+    lstring fullname;
+    while (!Signals::aborted && directory.more()) {
+        fullname.clear();
+        if (directory.is_directory()) {
+            directory.fullName(fullname);
+            if (acceptDir(fullname, directory.nameView(), dir.depth)) {
+                seenDirs.insert(directory.name());
+                if (dir.subdirs.insert(directory.name()).second)
+                    scanDir(fullname, dir.depth + 1, dir.rootIdx);
+            }
+        } else {
+            seenFiles.insert(directory.name());
+            updateFile(dir, path, directory.name());
+        }
+    }
+    if (Signals::aborted)
+        return;
+
+    for (auto file = dir.files.begin(); file != dir.files.end(); ) {
+        if (seenFiles.count(file->first) == 0) {
+            roots[dir.rootIdx].totals[file->second.ext] -= file->second.sums;
+            file = dir.files.erase(file);
+        } else {
+            ++file;
+        }
+    }
+    for (auto sub = dir.subdirs.begin(); sub != dir.subdirs.end(); ) {
+        if (seenDirs.count(*sub) == 0) {
+            removeTree(join(path, *sub));
+            sub = dir.subdirs.erase(sub);
+        } else {
+            ++sub;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Drop directory and everything below it. Keys below path all start with "path/", which is
+// one range, but path itself is not next to it ("a/b-x" sorts between "a/b" and "a/b/").
+void Watcher::removeTree(const std::string& path) {
+    auto self = dirs.find(path);
+    if (self != dirs.end()) {
+        dropDir(self->second);
+        dirs.erase(self);
+    }
+    std::string prefix = join(path, "");
+    auto first = dirs.lower_bound(prefix);
+    auto last = first;
+    while (last != dirs.end() && last->first.compare(0, prefix.length(), prefix) == 0) {
+        dropDir(last->second);
+        ++last;
+    }
+    dirs.erase(first, last);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Remove a directory's files from its root totals and stop watching it.
+void Watcher::dropDir(DirEntry& dir) {
+    for (const auto& file : dir.files)
+        roots[dir.rootIdx].totals[file.second.ext] -= file.second.sums;
+    if (dir.wd == -1) {
+        unwatched--;
+    } else {
+        watchPaths.erase(dir.wd);
+#ifdef HAVE_INOTIFY
+        inotify_rm_watch(notifyFd, dir.wd);
+#endif
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void Watcher::updateFile(DirEntry& dir, const std::string& dirPath, const std::string& name) {
+    removeFile(dir, name);
+    FileEntry entry;
+    if (examine(join(dirPath, name), name, entry.ext, entry.sums)) {
+        roots[dir.rootIdx].totals[entry.ext] += entry.sums;
+        dir.files.emplace(name, std::move(entry));
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void Watcher::removeFile(DirEntry& dir, const std::string& name) {
+    auto iter = dir.files.find(name);
+    if (iter != dir.files.end()) {
+        roots[dir.rootIdx].totals[iter->second.ext] -= iter->second.sums;
+        dir.files.erase(iter);
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Apply directory events now, queue file events for applyPending().
+void Watcher::readEvents() {
+#ifdef HAVE_INOTIFY
+    alignas(struct inotify_event) char buf[64 * 1024];
+    ssize_t len;
+    while ((len = read(notifyFd, buf, sizeof(buf))) > 0) {
+        for (char* ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            auto pathIter = watchPaths.find(event->wd);
+            if (pathIter == watchPaths.end())
+                continue;
+            std::string path = pathIter->second;
+            auto dirIter = dirs.find(path);
+            if (dirIter == dirs.end())
+                continue;
+            DirEntry& dir = dirIter->second;
+
+            if (event->mask & IN_IGNORED) {
+                // Watch dropped by the kernel (unmount), fall back to re-listing.
+                watchPaths.erase(event->wd);
+                dir.wd = -1;
+                unwatched++;
+                continue;
+            }
+            if (event->len == 0)
+                continue;   // event on the directory itself, its parent reports it
+
+            std::string name(event->name);
+            if (event->mask & IN_ISDIR) {
+                std::string fullname = join(path, name);
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    if (acceptDir(fullname, name, dir.depth) && dir.subdirs.insert(name).second)
+                        scanDir(fullname, dir.depth + 1, dir.rootIdx);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    if (dir.subdirs.erase(name) != 0)
+                        removeTree(fullname);
+                }
+            } else {
+                pending.emplace(path, name);
+            }
+        }
+    }
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// Stat each queued file once.
+void Watcher::applyPending() {
+    for (const auto& entry : pending) {
+        auto iter = dirs.find(entry.first);
+        if (iter != dirs.end())
+            updateFile(iter->second, entry.first, entry.second);
+    }
+    pending.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+void Watcher::run(unsigned seconds, ReportFunc report) {
+    typedef std::chrono::steady_clock Clock;
+    report(*this);
+    Clock::time_point nextReport = Clock::now() + std::chrono::seconds(seconds);
+
+    while (!Signals::aborted) {
+        auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(nextReport - Clock::now()).count();
+        if (waitMs > 0) {
+#ifdef HAVE_INOTIFY
+            struct pollfd pfd;
+            pfd.fd = notifyFd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, (notifyFd != -1) ? 1 : 0, (int)waitMs) > 0)
+                readEvents();
+#else
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<long long>(waitMs, 500)));
+#endif
+            continue;
+        }
+
+        applyPending();
+        std::vector<std::string> relist;
+        for (const auto& dir : dirs) {
+            if (overflow || dir.second.wd == -1)
+                relist.push_back(dir.first);
+        }
+        overflow = false;
+        for (const std::string& path : relist)
+            refreshDir(path);
+
+        if (Signals::aborted)
+            break;
+        report(*this);
+        nextReport = Clock::now() + std::chrono::seconds(seconds);
+    }
+}
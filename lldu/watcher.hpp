@@ -0,0 +1,86 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// -watch mode, keeps per directory totals up to date after one initial scan.
+//
+// Every directory is watched with inotify. Directory create, delete and move events update
+// the tree at once, file events only queue the entry, and queued entries are stat'ed once
+// per report interval however many events they produced.
+// When the kernel refuses more watches (fs.inotify.max_user_watches) the remaining
+// directories stay unwatched and are re-listed every interval instead. A queue overflow
+// re-lists every directory once.
+// fanotify would avoid the per directory watches but needs CAP_SYS_ADMIN, so it is not used.
+// Without inotify (not Linux) every directory is unwatched and re-listed each interval.
+
+#pragma once
+
+#include "ll_stdhdr.hpp"
+#include "dulist.hpp"
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class Watcher {
+public:
+    // Filter and measure one file, false if it is not counted.
+    typedef std::function<bool(const lstring& fullname, std::string_view name, std::string& ext, DuSums& sums)> ExamineFunc;
+    // True if subdirectory should be scanned, depth is its parent's depth.
+    typedef std::function<bool(const lstring& fullname, std::string_view name, unsigned depth)> AcceptDirFunc;
+    typedef std::function<void(const Watcher& watcher)> ReportFunc;
+
+    Watcher(ExamineFunc examine, AcceptDirFunc acceptDir);
+    ~Watcher();
+
+    // Initial scan of root, call before run().
+    void addRoot(const lstring& root);
+    // Report now and then every 'seconds' until Signals::aborted.
+    void run(unsigned seconds, ReportFunc report);
+
+    size_t rootCount() const { return roots.size(); }
+    const std::string& root(size_t rootIdx) const { return roots[rootIdx].path; }
+    // Current totals of root, extensions with nothing left are dropped.
+    void getTotals(size_t rootIdx, DuList& totals) const;
+    size_t unwatchedCount() const { return unwatched; }
+
+private:
+    struct FileEntry {
+        std::string ext;
+        DuSums sums;
+    };
+    struct DirEntry {
+        int wd;                 // inotify watch, -1 if unwatched
+        unsigned depth;
+        size_t rootIdx;
+        std::unordered_map<std::string, FileEntry> files;
+        std::set<std::string> subdirs;
+    };
+    struct Root {
+        std::string path;
+        DuList totals;
+    };
+
+    void scanDir(const std::string& path, unsigned depth, size_t rootIdx);
+    void refreshDir(const std::string& path);
+    void removeTree(const std::string& path);
+    void dropDir(DirEntry& dir);
+    void updateFile(DirEntry& dir, const std::string& dirPath, const std::string& name);
+    void removeFile(DirEntry& dir, const std::string& name);
+    void readEvents();
+    void applyPending();
+    static std::string join(const std::string& dirPath, std::string_view name);
+
+    ExamineFunc examine;
+    AcceptDirFunc acceptDir;
+    int notifyFd;
+    size_t unwatched;           // directories without a watch
+    bool overflow;              // events lost, re-list everything
+    std::vector<Root> roots;
+    std::map<std::string, DirEntry> dirs;               // ordered, a dir's descendants are one range
+    std::unordered_map<int, std::string> watchPaths;    // wd to directory path
+    std::set<std::pair<std::string, std::string>> pending;  // dir path, file name
+};
@@ -0,0 +1,98 @@
+// Copyright (c) 2026 Dennis Lang
+//
+
+#include "workpool.hpp"
+
+//-------------------------------------------------------------------------------------------------
+WorkPool::WorkPool(unsigned threadCnt) :
+    queued(0), pending(0), nextQueue(0), stopping(false) {
+    if (threadCnt == 0)
+        threadCnt = 1;
+    for (unsigned idx = 0; idx < threadCnt; idx++)
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for (unsigned idx = 0; idx < threadCnt; idx++)
+        threads.push_back(std::thread(&WorkPool::run, this, idx));
+}
+
+//-------------------------------------------------------------------------------------------------
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    idleCond.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+//-------------------------------------------------------------------------------------------------
+void WorkPool::submit(Task&& task, unsigned worker) {
+    if (worker >= queues.size())
+        worker = nextQueue++ % (unsigned)queues.size();
+
+    pending++;
+    {
+        Queue& queue = *queues[worker];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+        queued++;
+    }
+
+    // Take idleLock so a worker between its predicate check and wait() cannot miss the wakeup.
+    { std::lock_guard<std::mutex> guard(idleLock); }
+    idleCond.notify_one();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Pop newest task from own deque, else steal oldest task from another worker.
+bool WorkPool::pop(unsigned worker, Task& task) {
+    {
+        Queue& queue = *queues[worker];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    unsigned count = (unsigned)queues.size();
+    for (unsigned off = 1; off < count; off++) {
+        Queue& queue = *queues[(worker + off) % count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+void WorkPool::run(unsigned worker) {
+    Task task;
+    for (;;) {
+        if (pop(worker, task)) {
+            task(worker);
+            task = nullptr;
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> guard(doneLock);
+                doneCond.notify_all();
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(idleLock);
+            idleCond.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+void WorkPool::wait() {
+    std::unique_lock<std::mutex> lock(doneLock);
+    doneCond.wait(lock, [this] { return pending == 0; });
+}
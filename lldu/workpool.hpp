@@ -0,0 +1,56 @@
+// Copyright (c) 2026 Dennis Lang
+//
+// Work-stealing thread pool used by the parallel directory scan.
+//
+// Each worker owns a task deque. Tasks submitted by a worker go onto its own
+// deque and are popped LIFO (depth first, keeps memory bounded). Idle workers
+// steal FIFO from the other deques (oldest, usually largest, subtrees first).
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+class WorkPool {
+public:
+    typedef std::function<void(unsigned worker)> Task;
+    static const unsigned NOT_WORKER = ~0u;
+
+    WorkPool(unsigned threadCnt);
+    ~WorkPool();
+
+    unsigned size() const { return (unsigned)threads.size(); }
+
+    // Queue task, worker is caller's worker index or NOT_WORKER
+    void submit(Task&& task, unsigned worker = NOT_WORKER);
+
+    // Block until all submitted tasks (and tasks they submit) have completed.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(unsigned worker, Task& task);
+    void run(unsigned worker);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued;     // tasks sitting in deques
+    std::atomic<size_t> pending;    // tasks queued or running
+    std::atomic<unsigned> nextQueue;
+    std::mutex idleLock;
+    std::condition_variable idleCond;
+    std::mutex doneLock;
+    std::condition_variable doneCond;
+    bool stopping;
+};